@@ -6,82 +6,120 @@
 #include <iostream>
 #include <vector>
 
-namespace
-{
-
-struct file_closer
-{
-    void operator()(FILE * fp) const
-    {
-        if(fp)
-        {
-            std::fclose(fp);
-        };
-    };
-};
-
-using unique_file_ptr = std::unique_ptr<FILE, file_closer>;
-
-unique_file_ptr make_unique_file_ptr(char const * name, char const * mode)
-{
-    return unique_file_ptr{std::fopen(name, mode)};
-}
-
-} /* namespace */
-
-void save_png(
-    std::filesystem::path const & file, std::uint8_t const * data,
+png_writer::png_writer(
+    std::filesystem::path const & file,
     std::size_t const width, std::size_t const height)
 {
-    png_structp png_context =
+    m_context =
         png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 
-    if(!png_context)
+    if(!m_context)
     {
         std::cerr << "png_create_write_struct failed\n";
         return;
     }
 
-    if(setjmp(png_jmpbuf(png_context)))
+    if(setjmp(png_jmpbuf(m_context)))
     {
         std::cerr << "PNG I/O failed\n";
+        destroy();
         return;
     }
 
-    png_infop png_info_ptr = png_create_info_struct(png_context);
-    
-    if(!png_info_ptr)
+    m_info = png_create_info_struct(m_context);
+
+    if(!m_info)
     {
         std::cerr << "png_create_info_struct failed\n";
+        destroy();
         return;
     }
 
-    auto fp = make_unique_file_ptr(file.string().c_str(), "wb");
+    m_file = std::fopen(file.string().c_str(), "wb");
 
-    if(!fp)
+    if(!m_file)
     {
         std::cerr << "fopen failed\n";
+        destroy();
+        return;
     }
 
-    png_init_io(png_context, fp.get());
+    png_init_io(m_context, m_file);
 
     png_set_IHDR(
-        png_context,
-        png_info_ptr,
+        m_context,
+        m_info,
         width, height,
         8, // Bit-depth
         PNG_COLOR_TYPE_GRAY,
         PNG_INTERLACE_NONE,
         PNG_COMPRESSION_TYPE_BASE,
         PNG_FILTER_TYPE_BASE);
-    png_write_info(png_context, png_info_ptr);
+    png_write_info(m_context, m_info);
+}
 
-    for(auto y = 0ULL; y < height; ++y)
+png_writer::~png_writer()
+{
+    finish();
+}
+
+void png_writer::write_row(std::uint8_t const * row)
+{
+    if(!m_context)
+        return;
+
+    if(setjmp(png_jmpbuf(m_context)))
+    {
+        std::cerr << "PNG I/O failed\n";
+        destroy();
+        return;
+    }
+
+    png_write_row(m_context, row);
+}
+
+void png_writer::finish()
+{
+    if(!m_context)
+        return;
+
+    if(setjmp(png_jmpbuf(m_context)))
+    {
+        std::cerr << "PNG I/O failed\n";
+        destroy();
+        return;
+    }
+
+    png_write_end(m_context, nullptr);
+    destroy();
+}
+
+void png_writer::destroy()
+{
+    if(m_context)
     {
-        png_write_row(png_context, data + ((height-y-1) * width));
+        png_destroy_write_struct(&m_context, m_info ? &m_info : nullptr);
+        m_context = nullptr;
+        m_info = nullptr;
     }
 
-    png_write_end(png_context, nullptr);
+    if(m_file)
+    {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+void save_png(
+    std::filesystem::path const & file, std::uint8_t const * data,
+    std::size_t const width, std::size_t const height)
+{
+    auto writer = png_writer{file, width, height};
+
+    for(auto y = 0ULL; y < height; ++y)
+    {
+        writer.write_row(data + ((height-y-1) * width));
+    }
 
-    png_destroy_write_struct(&png_context, &png_info_ptr);
+    writer.finish();
 }
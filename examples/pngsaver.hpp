@@ -1,10 +1,41 @@
 #ifndef WTTF_EXAMPLES_PNGSAVER_HPP
 #define WTTF_EXAMPLES_PNGSAVER_HPP
 
+#include <png.h>
+
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <filesystem>
 
+/*
+ * Writes an 8-bit grayscale PNG file row by row, starting from the top
+ * row, so that the whole image never needs to be in memory.
+ */
+class png_writer
+{
+    public:
+    png_writer(
+        std::filesystem::path const & file,
+        std::size_t const width, std::size_t const height);
+    png_writer(png_writer const &) = delete;
+    ~png_writer();
+
+    png_writer & operator=(png_writer const &) = delete;
+
+    explicit operator bool() const { return m_context != nullptr; }
+
+    void write_row(std::uint8_t const * row);
+    void finish();
+
+    private:
+    void destroy();
+
+    png_structp m_context{nullptr};
+    png_infop m_info{nullptr};
+    std::FILE * m_file{nullptr};
+};
+
 void save_png(
     std::filesystem::path const & file, std::uint8_t const * data,
     std::size_t const width, std::size_t const height);
@@ -0,0 +1,262 @@
+#include <wttf/typeface.hpp>
+#include <wttf/typeface_cache.hpp>
+
+#include <fmt/format.h>
+#include <fmt/color.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * Writes a C++ header with the tables of a typeface_cache as constexpr
+ * arrays, for compiling a font into a program. The header defines
+ *
+ *   inline constexpr wttf::typeface_cache name{...};
+ *
+ * which is initialized at compile time. Nothing is parsed or allocated at
+ * run time, and the arrays are written with their types, so the header
+ * works for targets of any byte order.
+ */
+
+namespace
+{
+
+void usage(char const * program_name)
+{
+    std::cerr <<
+        fmt::format("Usage: {} ", program_name) <<
+        fmt::format(fmt::emphasis::underline, "font-file") <<
+        " " <<
+        fmt::format(fmt::emphasis::underline, "name") <<
+        " " <<
+        fmt::format(fmt::emphasis::underline, "header-file") <<
+        "\n";
+}
+
+wttf::typeface load_font(std::filesystem::path const & file)
+{
+    using iterator = std::istreambuf_iterator<char>;
+    std::ifstream fs{file, std::ios::binary};
+    auto contents = std::vector<std::byte>{};
+    std::transform(
+        iterator{fs}, iterator{}, std::back_inserter(contents),
+        [](auto c) { return static_cast<std::byte>(c); });
+
+    return wttf::typeface{std::move(contents)};
+}
+
+bool is_identifier(std::string_view name)
+{
+    auto const identifier_char = [](unsigned char c)
+    {
+        return std::isalnum(c) || c == '_';
+    };
+
+    return
+        !name.empty() &&
+        !std::isdigit(static_cast<unsigned char>(name.front())) &&
+        std::all_of(name.begin(), name.end(), identifier_char);
+}
+
+std::string to_upper(std::string s)
+{
+    std::transform(
+        s.begin(), s.end(), s.begin(),
+        [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return s;
+}
+
+// Shortest form, which reads back to the same float
+std::string float_literal(float value)
+{
+    auto s = fmt::format("{}", value);
+    if(s.find_first_of(".e") == std::string::npos)
+        s += ".0";
+
+    return s + "f";
+}
+
+std::string element(std::uint8_t v) { return fmt::format("{}", v); }
+std::string element(std::uint16_t v) { return fmt::format("{}", v); }
+std::string element(std::uint32_t v) { return fmt::format("{}", v); }
+std::string element(float v) { return float_literal(v); }
+
+std::string element(wttf::outline_view::coordinate const & c)
+{
+    return fmt::format("{{{}, {}}}", c.x, c.y);
+}
+
+std::string element(wttf::outline_store::entry const & e)
+{
+    return fmt::format(
+        "{{{}, {}, {}, {}, {}, {}, {}, {}}}",
+        e.first_point, e.first_flag_byte, e.first_contour, e.num_contours,
+        e.min_x, e.min_y, e.max_x, e.max_y);
+}
+
+/*
+ * Writes an array, count elements from data. An empty array is written
+ * with one element, so that the pointer to it is never null.
+ */
+template <typename T>
+void write_array(
+    std::ostream & out, std::string_view type, std::string_view name,
+    T const * data, std::size_t count)
+{
+    if(count == 0)
+    {
+        out << fmt::format("inline constexpr {} {}[1]{{}};\n\n", type, name);
+        return;
+    }
+
+    out << fmt::format("inline constexpr {} {}[] = {{\n", type, name);
+
+    auto line = std::string{"   "};
+    for(auto i = std::size_t{0}; i != count; ++i)
+    {
+        auto const e = element(data[i]) + ",";
+        if(line.size() + 1 + e.size() > 79)
+        {
+            out << line << "\n";
+            line = "   ";
+        }
+        line += " " + e;
+    }
+    out << line << "\n};\n\n";
+}
+
+void write_header(
+    std::ostream & out, std::string_view font_file, std::string_view name,
+    wttf::typeface_cache::tables const & t)
+{
+    auto const guard = fmt::format(
+        "WTTF_GENERATED_{}_HPP", to_upper(std::string{name}));
+
+    out << fmt::format(
+        "// Generated by ttf2cpp from {}. Do not edit.\n\n", font_file);
+    out << fmt::format("#ifndef {}\n#define {}\n\n", guard, guard);
+    out << "#include <wttf/typeface_cache.hpp>\n\n";
+    out << "#include <cstdint>\n\n";
+    out << fmt::format("namespace {}_tables\n{{\n\n", name);
+
+    write_array(
+        out, "std::uint16_t", "cmap_index", t.cmap_index, t.cmap_index_size);
+    write_array(
+        out, "std::uint16_t", "cmap_pages", t.cmap_pages,
+        t.num_cmap_pages * 256);
+    write_array(
+        out, "float", "glyph_metrics", t.glyph_metrics, t.num_glyphs * 6);
+    write_array(
+        out, "std::uint32_t", "kerning_pairs", t.kerning_pairs,
+        t.num_kerning_pairs);
+    write_array(
+        out, "float", "kerning_values", t.kerning_values,
+        t.num_kerning_pairs);
+    write_array(
+        out, "std::uint32_t", "outline_index", t.outline_index,
+        t.outline_index ? t.num_glyphs : 0);
+    write_array(
+        out, "wttf::outline_store::entry", "outline_entries",
+        t.outline_entries, t.num_outline_entries);
+    write_array(
+        out, "wttf::outline_view::coordinate", "points", t.points,
+        t.num_points);
+    write_array(
+        out, "std::uint8_t", "on_curve", t.on_curve, t.num_on_curve_bytes);
+    write_array(
+        out, "std::uint32_t", "contour_ends", t.contour_ends,
+        t.num_contour_ends);
+
+    out << fmt::format("}} /* namespace {}_tables */\n\n", name);
+
+    out << fmt::format(
+        "inline constexpr wttf::typeface_cache {}{{\n"
+        "    []()\n"
+        "    {{\n"
+        "        namespace d = {}_tables;\n"
+        "        auto t = wttf::typeface_cache::tables{{}};\n"
+        "        t.num_glyphs = {};\n"
+        "        t.metrics = {{{}, {}, {}}};\n"
+        "        t.cmap_index = d::cmap_index;\n"
+        "        t.cmap_index_size = {};\n"
+        "        t.cmap_pages = d::cmap_pages;\n"
+        "        t.num_cmap_pages = {};\n"
+        "        t.glyph_metrics = d::glyph_metrics;\n"
+        "        t.kerning_pairs = d::kerning_pairs;\n"
+        "        t.kerning_values = d::kerning_values;\n"
+        "        t.num_kerning_pairs = {};\n",
+        name, name, t.num_glyphs,
+        float_literal(t.metrics.ascent), float_literal(t.metrics.descent),
+        float_literal(t.metrics.line_gap),
+        t.cmap_index_size, t.num_cmap_pages, t.num_kerning_pairs);
+
+    if(t.outline_index)
+    {
+        out << fmt::format(
+            "        t.outline_index = d::outline_index;\n"
+            "        t.outline_entries = d::outline_entries;\n"
+            "        t.num_outline_entries = {};\n"
+            "        t.points = d::points;\n"
+            "        t.num_points = {};\n"
+            "        t.on_curve = d::on_curve;\n"
+            "        t.num_on_curve_bytes = {};\n"
+            "        t.contour_ends = d::contour_ends;\n"
+            "        t.num_contour_ends = {};\n",
+            t.num_outline_entries, t.num_points, t.num_on_curve_bytes,
+            t.num_contour_ends);
+    }
+
+    out << "        return t;\n    }()};\n\n";
+    out << fmt::format("#endif /* {} */\n", guard);
+}
+
+}
+
+int main(int argc, char const * argv[])
+{
+    if(argc < 4)
+    {
+        std::cerr << fmt::format("{}: too few arguments\n", argv[0]);
+        usage(argv[0]);
+        return 1;
+    }
+
+    auto const name = std::string_view{argv[2]};
+    if(!is_identifier(name))
+    {
+        std::cerr << fmt::format("{}: invalid name \"{}\"\n", argv[0], name);
+        return 1;
+    }
+
+    auto const typeface = load_font(argv[1]);
+    if(!typeface || typeface.error() != wttf::font_error::none)
+    {
+        std::cerr << fmt::format("{}: Invalid font file\n", argv[0]);
+        return 1;
+    }
+
+    auto const blob = wttf::typeface_cache::serialize(typeface, true);
+    auto const cache = wttf::typeface_cache{blob.data(), blob.size()};
+
+    auto const font_file = std::filesystem::path{argv[1]}.filename();
+    std::ofstream out{argv[3]};
+    write_header(out, font_file.string(), name, cache.contents());
+    out.close();
+
+    if(!out)
+    {
+        std::cerr << fmt::format("{}: cannot write {}\n", argv[0], argv[3]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -36,7 +36,9 @@ void usage(char const * program_name)
         fmt::format(fmt::emphasis::underline, "text-file") <<
         " " <<
         fmt::format(fmt::emphasis::underline, "png-file") <<
-        "\n";
+        " [" <<
+        fmt::format(fmt::emphasis::underline, "band-height") <<
+        "]\n";
 }
 
 wttf::typeface load_font(std::filesystem::path const & file)
@@ -194,13 +196,21 @@ wttf::shape draw_text(icu::UnicodeString const & text, wttf::typeface const & fo
 
 int main(int argc, char const * argv[])
 {
-    if(argc != 5)
+    if(argc != 5 && argc != 6)
     {
         usage(argv[0]);
         return 1;
     }
 
     auto const typeface = load_font(argv[1]);
+    if(!typeface)
+    {
+        std::cerr << fmt::format(
+            "Invalid font file: {} (error {})\n",
+            argv[1], static_cast<int>(typeface.error()));
+        return 1;
+    }
+
     auto const font_size = std::stof(argv[2]);
     auto const text = load_text_file(argv[3]);
     auto const scale = font_size / typeface.metrics().height();
@@ -211,6 +221,31 @@ int main(int argc, char const * argv[])
     auto const image_height =
         static_cast<std::size_t>(std::ceil(shape.height()));
 
+    if(argc == 6)
+    {
+        // Render and write the image in bands, without ever holding the
+        // whole image in memory.
+        auto const band_height = std::stoul(argv[5]);
+        auto writer = png_writer{argv[4], image_width, image_height};
+        auto const rasterizer = wttf::rasterizer{image_width, image_height};
+
+        rasterizer.rasterize_bands(
+            shape, -shape.min_x(), -shape.min_y(), band_height,
+            [&writer](
+                std::uint8_t const * band, std::size_t,
+                std::size_t rows, std::ptrdiff_t stride)
+            {
+                for(auto row = rows; row != 0; --row)
+                {
+                    writer.write_row(
+                        band + static_cast<std::ptrdiff_t>(row-1) * stride);
+                }
+            });
+
+        writer.finish();
+        return 0;
+    }
+
     auto image_data = std::vector<std::uint8_t>{};
     image_data.resize(image_width*image_height);
 
@@ -0,0 +1,89 @@
+#ifndef WTTF_COVERAGE_MASK_HPP
+#define WTTF_COVERAGE_MASK_HPP
+
+#include "export.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wttf
+{
+
+/*
+ * Run-length encoded 8-bit coverage, for caching rasterized glyphs. Each
+ * row is a list of segments; pixels not in any segment have zero coverage.
+ * Segment is either solid, with uniform coverage, or literal, with one
+ * coverage byte per pixel. Literal bytes of a row are stored in order of
+ * the segments. Mask is at most 65535 pixels wide.
+ */
+class WTTF_EXPORT coverage_mask
+{
+    public:
+    struct segment
+    {
+        std::uint16_t x; // Relative to x() of the mask
+        std::uint16_t length;
+        std::uint8_t coverage; // Coverage of solid segment
+        bool literal;
+    };
+
+    struct row_view
+    {
+        segment const * begin;
+        segment const * end;
+        std::uint8_t const * literals;
+    };
+
+    coverage_mask() = default;
+    coverage_mask(coverage_mask const &) = default;
+    coverage_mask(coverage_mask &&) = default;
+
+    ~coverage_mask() = default;
+
+    coverage_mask & operator=(coverage_mask const &) = default;
+    coverage_mask & operator=(coverage_mask &&) = default;
+
+    // Position of the lower-left corner, in pixels of the rasterizer area
+    [[nodiscard]] std::size_t x() const { return m_x; }
+    [[nodiscard]] std::size_t y() const { return m_y; }
+    [[nodiscard]] std::size_t width() const { return m_width; }
+    [[nodiscard]] std::size_t height() const { return m_height; }
+    [[nodiscard]] bool empty() const { return m_segments.empty(); }
+
+    // Row y, relative to y() of the mask
+    [[nodiscard]] row_view row(std::size_t y) const;
+
+    // Memory used by the encoded data
+    [[nodiscard]] std::size_t size_in_bytes() const;
+
+    private:
+    friend class rasterizer;
+
+    struct row_start
+    {
+        std::uint32_t segment;
+        std::uint32_t literal;
+    };
+
+    coverage_mask(
+        std::size_t x, std::size_t y,
+        std::size_t width, std::size_t height);
+
+    void add_span(
+        std::size_t y, std::size_t x, std::size_t count,
+        std::uint8_t coverage);
+    void finish();
+
+    std::vector<segment> m_segments{};
+    std::vector<std::uint8_t> m_literals{};
+    std::vector<row_start> m_rows{};
+    std::size_t m_x{0};
+    std::size_t m_y{0};
+    std::size_t m_width{0};
+    std::size_t m_height{0};
+};
+
+} /* namespace wttf */
+
+#endif /* WTTF_COVERAGE_MASK_HPP */
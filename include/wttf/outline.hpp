@@ -0,0 +1,188 @@
+#ifndef WTTF_OUTLINE_HPP
+#define WTTF_OUTLINE_HPP
+
+#include "export.hpp"
+#include "shape.hpp"
+#include "transform.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wttf
+{
+
+/*
+ * Read-only view of a compact outline, stored in an outline or in an
+ * outline_store. Points of contour i are [contour_start(i), contour_end(i)).
+ */
+class WTTF_EXPORT outline_view
+{
+    public:
+    struct coordinate
+    {
+        std::int16_t x;
+        std::int16_t y;
+    };
+
+    outline_view() = default;
+
+    /*
+     * On-curve flags are bits, in order of the points, starting from the
+     * lowest bit of the first byte. Contour ends are indices of the first
+     * point after each contour.
+     */
+    outline_view(
+        coordinate const * points, std::uint8_t const * on_curve,
+        std::uint32_t const * contour_ends, std::size_t num_contours,
+        std::int16_t min_x, std::int16_t min_y,
+        std::int16_t max_x, std::int16_t max_y):
+        m_points{points},
+        m_on_curve{on_curve},
+        m_contour_ends{contour_ends},
+        m_num_contours{num_contours},
+        m_min_x{min_x}, m_min_y{min_y},
+        m_max_x{max_x}, m_max_y{max_y}
+    {}
+
+    [[nodiscard]] std::size_t num_contours() const { return m_num_contours; }
+
+    [[nodiscard]] std::size_t num_points() const
+    {
+        return m_num_contours ? m_contour_ends[m_num_contours-1] : 0;
+    }
+
+    [[nodiscard]] bool empty() const { return num_points() == 0; }
+
+    [[nodiscard]] std::size_t contour_start(std::size_t i) const
+    {
+        return i ? m_contour_ends[i-1] : 0;
+    }
+
+    [[nodiscard]] std::size_t contour_end(std::size_t i) const
+    {
+        return m_contour_ends[i];
+    }
+
+    [[nodiscard]] coordinate const & position(std::size_t i) const
+    {
+        return m_points[i];
+    }
+
+    [[nodiscard]] bool on_curve(std::size_t i) const
+    {
+        return (m_on_curve[i / 8] >> (i % 8)) & 1u;
+    }
+
+    [[nodiscard]] std::int16_t min_x() const { return m_min_x; }
+    [[nodiscard]] std::int16_t min_y() const { return m_min_y; }
+    [[nodiscard]] std::int16_t max_x() const { return m_max_x; }
+    [[nodiscard]] std::int16_t max_y() const { return m_max_y; }
+
+    [[nodiscard]] shape to_shape() const;
+    [[nodiscard]] shape to_shape(transform const & t) const;
+
+    private:
+    coordinate const * m_points{nullptr};
+    std::uint8_t const * m_on_curve{nullptr};
+    std::uint32_t const * m_contour_ends{nullptr};
+    std::size_t m_num_contours{0};
+    std::int16_t m_min_x{0};
+    std::int16_t m_min_y{0};
+    std::int16_t m_max_x{0};
+    std::int16_t m_max_y{0};
+}; /* class outline_view */
+
+/*
+ * Glyph outline in font units, stored compactly for caching. Coordinates
+ * are 16-bit integers and on-curve flags are packed into bits, so a point
+ * takes a bit over four bytes, instead of twelve bytes of shape::vertex.
+ * Points of all contours are stored in one array.
+ */
+class WTTF_EXPORT outline
+{
+    public:
+    using coordinate = outline_view::coordinate;
+
+    outline() = default;
+    outline(outline const &) = default;
+    outline(outline &&) = default;
+
+    ~outline() = default;
+
+    outline & operator=(outline const &) = default;
+    outline & operator=(outline &&) = default;
+
+    [[nodiscard]] std::size_t num_contours() const
+    {
+        return m_contour_ends.size();
+    }
+
+    [[nodiscard]] std::size_t num_points() const { return m_points.size(); }
+    [[nodiscard]] bool empty() const { return m_points.empty(); }
+
+    // Points of contour i are [contour_start(i), contour_end(i))
+    [[nodiscard]] std::size_t contour_start(std::size_t i) const
+    {
+        return i ? m_contour_ends[i-1] : 0;
+    }
+
+    [[nodiscard]] std::size_t contour_end(std::size_t i) const
+    {
+        return m_contour_ends[i];
+    }
+
+    [[nodiscard]] coordinate const & position(std::size_t i) const
+    {
+        return m_points[i];
+    }
+
+    [[nodiscard]] bool on_curve(std::size_t i) const
+    {
+        return (m_on_curve[i / 8] >> (i % 8)) & 1u;
+    }
+
+    [[nodiscard]] std::int16_t min_x() const { return m_min_x; }
+    [[nodiscard]] std::int16_t min_y() const { return m_min_y; }
+    [[nodiscard]] std::int16_t max_x() const { return m_max_x; }
+    [[nodiscard]] std::int16_t max_y() const { return m_max_y; }
+
+    // Starts a new contour, with room for s points
+    void add_contour(std::size_t s = 0);
+    void add_vertex(std::int16_t x, std::int16_t y, bool on_curve);
+
+    // Frees unused capacity, once the outline is complete
+    void shrink_to_fit();
+
+    [[nodiscard]] shape to_shape() const { return view().to_shape(); }
+    [[nodiscard]] shape to_shape(transform const & t) const
+    {
+        return view().to_shape(t);
+    }
+
+    [[nodiscard]] outline_view view() const
+    {
+        return {
+            m_points.data(), m_on_curve.data(),
+            m_contour_ends.data(), m_contour_ends.size(),
+            m_min_x, m_min_y, m_max_x, m_max_y};
+    }
+
+    operator outline_view() const { return view(); }
+
+    // Memory used by the outline data
+    [[nodiscard]] std::size_t size_in_bytes() const;
+
+    private:
+    std::vector<coordinate> m_points{};
+    std::vector<std::uint8_t> m_on_curve{};
+    std::vector<std::uint32_t> m_contour_ends{};
+    std::int16_t m_min_x{0};
+    std::int16_t m_min_y{0};
+    std::int16_t m_max_x{0};
+    std::int16_t m_max_y{0};
+}; /* class outline */
+
+} /* namespace wttf */
+
+#endif /* WTTF_OUTLINE_HPP */
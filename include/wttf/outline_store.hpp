@@ -0,0 +1,80 @@
+#ifndef WTTF_OUTLINE_STORE_HPP
+#define WTTF_OUTLINE_STORE_HPP
+
+#include "export.hpp"
+#include "outline.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wttf
+{
+
+/*
+ * Outlines of many glyphs of a typeface, decoded at once by
+ * typeface::glyph_outlines. All outlines share the same few arrays, instead
+ * of each having its own allocations. Outlines are accessed by glyph index.
+ */
+class WTTF_EXPORT outline_store
+{
+    public:
+    outline_store() = default;
+    outline_store(outline_store const &) = default;
+    outline_store(outline_store &&) = default;
+
+    ~outline_store() = default;
+
+    outline_store & operator=(outline_store const &) = default;
+    outline_store & operator=(outline_store &&) = default;
+
+    // Number of glyphs in the store
+    [[nodiscard]] std::size_t size() const { return m_entries.size(); }
+
+    [[nodiscard]] bool contains(std::uint16_t glyph_index) const
+    {
+        return
+            glyph_index < m_index.size() &&
+            m_index[glyph_index] != no_entry;
+    }
+
+    // Outline of a glyph, or an empty outline if the glyph is not stored.
+    // Valid as long as the store is not modified or destroyed.
+    [[nodiscard]] outline_view operator[](std::uint16_t glyph_index) const;
+
+    // Memory used by the outline data
+    [[nodiscard]] std::size_t size_in_bytes() const;
+
+    /*
+     * Position of an outline in the shared arrays. Contour ends of a glyph
+     * are relative to its first point, and its on-curve flags start from a
+     * new byte.
+     */
+    struct entry
+    {
+        std::uint32_t first_point;
+        std::uint32_t first_flag_byte;
+        std::uint32_t first_contour;
+        std::uint32_t num_contours;
+        std::int16_t min_x;
+        std::int16_t min_y;
+        std::int16_t max_x;
+        std::int16_t max_y;
+    };
+
+    private:
+    friend class typeface;
+    friend class typeface_cache;
+
+    static constexpr std::uint32_t no_entry = 0xFFFFFFFF;
+
+    std::vector<std::uint32_t> m_index{};
+    std::vector<entry> m_entries{};
+    std::vector<outline_view::coordinate> m_points{};
+    std::vector<std::uint8_t> m_on_curve{};
+    std::vector<std::uint32_t> m_contour_ends{};
+}; /* class outline_store */
+
+} /* namespace wttf */
+
+#endif /* WTTF_OUTLINE_STORE_HPP */
@@ -0,0 +1,54 @@
+#ifndef WTTF_PAINT_HPP
+#define WTTF_PAINT_HPP
+
+#include "export.hpp"
+
+#include <cstdint>
+
+namespace wttf
+{
+
+/*
+ * How rasterized coverage is combined with the pixels already in the
+ * target image. Source value is the paint color scaled by coverage and
+ * alpha.
+ *
+ *  replace     - Source value overwrites the target, including pixels with
+ *                zero coverage inside the bounding box of the shape.
+ *  max         - Target becomes the maximum of source and target.
+ *  add         - Source is added to the target, saturating at full value.
+ *  source_over - Source is composited over the target (Porter-Duff).
+ *
+ * All modes, except replace, leave pixels with zero coverage untouched.
+ */
+enum class blend_mode: std::uint8_t
+{
+    replace,
+    max,
+    add,
+    source_over
+};
+
+struct WTTF_EXPORT color
+{
+    std::uint8_t r{0xFF};
+    std::uint8_t g{0xFF};
+    std::uint8_t b{0xFF};
+
+    // Single channel targets use the luminance of the color.
+    [[nodiscard]] constexpr std::uint8_t luminance() const noexcept
+    {
+        return static_cast<std::uint8_t>((77*r + 150*g + 29*b + 128) >> 8);
+    }
+};
+
+struct WTTF_EXPORT paint
+{
+    blend_mode mode{blend_mode::replace};
+    wttf::color color{};
+    std::uint8_t alpha{0xFF};
+};
+
+} /* namespace wttf */
+
+#endif /* WTTF_PAINT_HPP */
@@ -0,0 +1,59 @@
+#ifndef WTTF_PIXEL_FORMAT_HPP
+#define WTTF_PIXEL_FORMAT_HPP
+
+#include "export.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wttf
+{
+
+namespace pixel_format
+{
+
+// 8-bit coverage (or grayscale), one byte per pixel
+struct a8
+{
+    using channel_type = std::uint8_t;
+    static constexpr std::size_t channels = 1;
+};
+
+// 8-bit RGBA with premultiplied alpha, bytes in order R, G, B, A
+struct rgba8
+{
+    using channel_type = std::uint8_t;
+    static constexpr std::size_t channels = 4;
+};
+
+// 8-bit BGRA with premultiplied alpha, bytes in order B, G, R, A
+struct bgra8
+{
+    using channel_type = std::uint8_t;
+    static constexpr std::size_t channels = 4;
+};
+
+// Unquantized coverage, one float in range [0, 1] per pixel
+struct float_coverage
+{
+    using channel_type = float;
+    static constexpr std::size_t channels = 1;
+};
+
+} /* namespace pixel_format */
+
+template <typename Format>
+struct image_view
+{
+    using format = Format;
+    using channel_type = typename Format::channel_type;
+
+    channel_type * data{nullptr}; // Lower-left most pixel
+    std::size_t width{0};
+    std::size_t height{0};
+    std::ptrdiff_t stride{0}; // Distance to the row above, in bytes
+};
+
+} /* namespace wttf */
+
+#endif /* WTTF_PIXEL_FORMAT_HPP */
@@ -1,18 +1,82 @@
 #ifndef WTTF_RASTERIZER_HPP
 #define WTTF_RASTERIZER_HPP
 
+#include "coverage_mask.hpp"
 #include "export.hpp"
+#include "paint.hpp"
+#include "pixel_format.hpp"
 #include "shape.hpp"
+#include "span_sink.hpp"
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 
 namespace wttf
 {
 
+/*
+ * Algorithm used for computing coverage.
+ *
+ *  floating_point - Analytic coverage, computed in single precision.
+ *  fixed_point    - Area accumulation in 24.8 fixed-point integers. No
+ *                   divisions per pixel, and the output is bit-identical
+ *                   on all compilers and CPUs.
+ *  tiled          - Same output as fixed_point, but the work is done in
+ *                   tiles, and only tiles crossed by edges are processed
+ *                   pixel by pixel. Fastest for large, mostly empty areas.
+ *                   With blend modes other than replace, and with span
+ *                   sinks, empty tiles are not touched at all. Replace
+ *                   clears them, a band of tiles at a time.
+ */
+enum class raster_engine: std::uint8_t
+{
+    floating_point,
+    fixed_point,
+    tiled
+};
+
+/*
+ * Rule for deciding which parts of overlapping contours are inside.
+ *
+ *  non_zero - Inside, if winding number is not zero.
+ *  even_odd - Inside, if winding number is odd. Overlapping areas of two
+ *             contours are left empty.
+ */
+enum class fill_rule: std::uint8_t
+{
+    non_zero,
+    even_odd
+};
+
+class outline_view;
+class typeface;
+
+// Rectangle of pixels, [x, x+width) horizontally and [y, y+height) vertically
+struct WTTF_EXPORT clip_rect
+{
+    std::size_t x{0};
+    std::size_t y{0};
+    std::size_t width{0};
+    std::size_t height{0};
+};
+
 class WTTF_EXPORT rasterizer
 {
     public:
+    /*
+     * Receives one band of 8-bit coverage: rows [first_row, first_row+rows)
+     * of the image. Band points to the lowest row of the band and stride is
+     * the distance to the row above, in bytes. The data is valid only
+     * during the call.
+     */
+    using band_callback = std::function<void(
+        std::uint8_t const * band,
+        std::size_t first_row,
+        std::size_t rows,
+        std::ptrdiff_t stride)>;
+
     rasterizer();
     rasterizer(rasterizer const &) = delete;
     rasterizer(rasterizer &&);
@@ -23,12 +87,90 @@ class WTTF_EXPORT rasterizer
         std::size_t height,
         std::ptrdiff_t stride);
 
+    explicit rasterizer(image_view<pixel_format::a8> const & target);
+    explicit rasterizer(image_view<pixel_format::rgba8> const & target);
+    explicit rasterizer(image_view<pixel_format::bgra8> const & target);
+    explicit rasterizer(
+        image_view<pixel_format::float_coverage> const & target);
+
+    // Rasterizer without target image, for use with span_sink
+    rasterizer(std::size_t width, std::size_t height);
+
     ~rasterizer();
 
     rasterizer & operator=(rasterizer const &) = delete;
     rasterizer & operator=(rasterizer &&);
 
-    void rasterize(shape const & s, float x_offset, float y_offset) const;
+    void rasterize(
+        shape const & s, float x_offset, float y_offset,
+        paint const & p = {}) const;
+    void rasterize(
+        shape const & s, float x_offset, float y_offset,
+        span_sink & sink) const;
+
+    /*
+     * Rasterizes the shape transformed by t. The transform is applied to
+     * the vertices while building the edges, and curves are flattened after
+     * the transform, so the shape itself is not copied.
+     */
+    void rasterize(
+        shape const & s, transform const & t, paint const & p = {}) const;
+    void rasterize(
+        shape const & s, transform const & t, span_sink & sink) const;
+
+    // Rasterizes a compact outline, from an outline or an outline_store,
+    // transformed by t
+    void rasterize(
+        outline_view const & o, transform const & t,
+        paint const & p = {}) const;
+    void rasterize(
+        outline_view const & o, transform const & t,
+        span_sink & sink) const;
+
+    /*
+     * Rasterizes a glyph directly from the font. The outline is transformed
+     * by t, from font units to pixels, and its curves are flattened while
+     * the font data is decoded, without creating any shapes in between.
+     */
+    void rasterize_glyph(
+        typeface const & face, std::uint16_t glyph_index,
+        transform const & t, paint const & p = {}) const;
+
+    /*
+     * Rasterizes the whole width x height area in horizontal bands of at
+     * most band_height rows, from the top row down, using a buffer of one
+     * band only. Target image of the rasterizer, if any, is not used.
+     */
+    void rasterize_bands(
+        shape const & s, float x_offset, float y_offset,
+        std::size_t band_height, band_callback const & callback) const;
+
+    /*
+     * Rasterizes into a run-length encoded mask instead of the target image.
+     * Mask covers the pixels of the shape within the rasterizer area.
+     */
+    [[nodiscard]] coverage_mask rasterize_mask(
+        shape const & s, float x_offset, float y_offset) const;
+
+    // Draws the mask into the target image, moved by whole pixels.
+    void blit(
+        coverage_mask const & mask,
+        std::ptrdiff_t x_offset, std::ptrdiff_t y_offset,
+        paint const & p = {}) const;
+
+    [[nodiscard]] raster_engine engine() const;
+    void set_engine(raster_engine e);
+    [[nodiscard]] wttf::fill_rule fill_rule() const;
+    void set_fill_rule(wttf::fill_rule r);
+
+    /*
+     * Restricts all output to the clip rectangle, which is limited to the
+     * area of the rasterizer. Pixels outside are left untouched, and edges
+     * outside do not cost anything. By default the whole area is drawn.
+     */
+    [[nodiscard]] clip_rect clip() const;
+    void set_clip(clip_rect const & r);
+    void reset_clip();
 
     private:
     class implementation;
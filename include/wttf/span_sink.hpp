@@ -0,0 +1,35 @@
+#ifndef WTTF_SPAN_SINK_HPP
+#define WTTF_SPAN_SINK_HPP
+
+#include "export.hpp"
+
+#include <cstddef>
+
+namespace wttf
+{
+
+// Horizontal run of pixels [x_begin, x_end) with uniform coverage
+struct WTTF_EXPORT span
+{
+    std::size_t x_begin;
+    std::size_t x_end;
+    float coverage; // In range (0, 1]
+};
+
+/*
+ * Receiver of rasterizer output, for consumers that do not want a bitmap.
+ * The rasterizer calls row() once for every row that has coverage, in
+ * order of increasing y. Spans within a row are sorted by x and do not
+ * overlap. Runs with zero coverage are not reported.
+ */
+class WTTF_EXPORT span_sink
+{
+    public:
+    virtual ~span_sink();
+
+    virtual void row(std::size_t y, span const * spans, std::size_t count) = 0;
+};
+
+} /* namespace wttf */
+
+#endif /* WTTF_SPAN_SINK_HPP */
@@ -39,6 +39,21 @@ struct WTTF_EXPORT transform
     }
 }; /* struct transform */
 
+// Transform that applies b first and then a
+inline transform operator*(transform const & a, transform const & b)
+{
+    auto const & m = a.matrix;
+    auto const & n = b.matrix;
+
+    return {
+        m[0]*n[0] + m[2]*n[1],
+        m[1]*n[0] + m[3]*n[1],
+        m[0]*n[2] + m[2]*n[3],
+        m[1]*n[2] + m[3]*n[3],
+        m[0]*n[4] + m[2]*n[5] + m[4],
+        m[1]*n[4] + m[3]*n[5] + m[5]};
+}
+
 } /* namespace wttf */
 
 #endif /* WTTF_TRANSFORM_HPP */
@@ -4,9 +4,12 @@
 #include "export.hpp"
 #include "shape.hpp"
 #include "metrics.hpp"
+#include "outline.hpp"
+#include "outline_store.hpp"
 
 #include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <map>
 #include <memory>
 #include <vector>
@@ -18,6 +21,32 @@ struct font_data;
 
 class typeface;
 
+// Reason why font data was rejected when constructing a typeface
+enum class font_error
+{
+    none,
+    bad_table_directory, // Table directory or a table is outside the data
+    missing_table, // A table required for TrueType outlines is missing
+    bad_header, // head, maxp or hhea table is too short or invalid
+    bad_cmap,
+    bad_loca,
+    bad_glyph, // Glyph record or a component of it is invalid
+    bad_metrics,
+    bad_kern,
+    bad_file // Font file could not be opened or read
+};
+
+/*
+ * TrueType font data with a subset of the glyphs of a typeface, made by
+ * typeface::subset. Glyphs keep their order, but are renumbered: glyph i of
+ * the subset is glyph glyphs[i] of the original typeface.
+ */
+struct font_subset
+{
+    std::vector<std::byte> data{};
+    std::vector<std::uint16_t> glyphs{};
+};
+
 #if WTTF_FONT_COLLECTION_IMPLEMENTED
 class WTTF_EXPORT font_collection
 {
@@ -48,8 +77,24 @@ class WTTF_EXPORT typeface
     typeface(typeface const & other);
     typeface(typeface && other) = delete;
 
+    /*
+     * The table directory and the small fixed size tables are checked here.
+     * If they are not valid, the typeface is left empty, and error() tells
+     * why. Other tables are checked and parsed on first use, so that reading
+     * them needs no bounds checks later. A table failing the check is
+     * treated as empty. error() checks also the tables not used yet.
+     */
     explicit typeface(std::vector<std::byte> && data);
 
+    /*
+     * Reads the font from a file on demand, instead of reading all of it to
+     * memory: only the parts used are read, in pages, which are kept as
+     * long as the typeface or its copies exist. Checks are as above, except
+     * that glyphs are checked one by one on first use, and an invalid glyph
+     * is treated as empty. error() does not check glyphs.
+     */
+    explicit typeface(std::filesystem::path const & file);
+
 #if WTTF_FONT_COLLECTION_IMPLEMENTED
     typeface(font_collection const & collection, std::size_t index);
 #endif
@@ -60,7 +105,9 @@ class WTTF_EXPORT typeface
     typeface & operator=(typeface && other) = delete;
 
     explicit operator bool() const;
+    [[nodiscard]] font_error error() const;
 
+    [[nodiscard]] std::size_t num_glyphs() const;
     [[nodiscard]] std::size_t glyph_index(unsigned int codepoint) const;
     [[nodiscard]] shape glyph_shape(std::uint16_t index) const;
     [[nodiscard]] glyph_metrics metrics(std::uint16_t index) const;
@@ -68,13 +115,50 @@ class WTTF_EXPORT typeface
     [[nodiscard]] float kerning(
         std::uint16_t glyph1, std::uint16_t glyph2) const;
 
+    /*
+     * Outline of a glyph in compact form, for caching. Components of
+     * composite glyphs, which are scaled, are rounded to whole font units.
+     */
+    [[nodiscard]] outline glyph_outline(std::uint16_t index) const;
+
+    /*
+     * Outlines of all glyphs, or of the given glyphs, decoded in parallel on
+     * up to threads threads (zero for one per hardware thread). Each outline
+     * equals the one returned by glyph_outline. Components shared by
+     * composite glyphs are decoded only once.
+     */
+    [[nodiscard]] outline_store glyph_outlines(std::size_t threads = 0) const;
+    [[nodiscard]] outline_store glyph_outlines(
+        std::vector<std::uint16_t> const & glyphs,
+        std::size_t threads = 0) const;
+
+    /*
+     * Builds font data with only the given glyphs, and the glyphs they use
+     * as components, for constructing a smaller typeface. Glyph 0 is always
+     * included. The character map keeps the codepoints of the included
+     * glyphs, and kerning the pairs of them. Tables, which typeface does not
+     * read, are left out. Returns empty data if the glyphs of this typeface
+     * are not valid.
+     */
+    [[nodiscard]] font_subset subset(
+        std::vector<std::uint16_t> const & glyphs) const;
+
+    // Same as subset, with the glyphs of the given codepoints. The character
+    // map has only these codepoints.
+    [[nodiscard]] font_subset subset_codepoints(
+        std::vector<unsigned int> const & codepoints) const;
+
     private:
+    friend class rasterizer;
+    friend class typeface_cache;
+
     class implementation;
 
     typeface(
         std::shared_ptr<font_data const> const & data, std::size_t offset);
 
     std::shared_ptr<implementation> m_impl;
+    font_error m_error{font_error::none};
 }; /* class typeface */
 
 } /* namespace wttf */
@@ -0,0 +1,139 @@
+#ifndef WTTF_TYPEFACE_CACHE_HPP
+#define WTTF_TYPEFACE_CACHE_HPP
+
+#include "export.hpp"
+#include "metrics.hpp"
+#include "outline.hpp"
+#include "outline_store.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wttf
+{
+
+class typeface;
+
+/*
+ * Typeface preprocessed into a wttf specific binary blob, for loading
+ * without parsing the font. The blob contains the character map as a flat
+ * lookup table, glyph metrics as arrays of each field, kerning pairs as a
+ * sorted array and, optionally, decoded outlines of all glyphs.
+ *
+ * The blob is written by serialize, and read in place: typeface_cache only
+ * points into it, so it can be mapped from a file and used without copying.
+ * The blob is in the byte order of the machine writing it.
+ */
+class WTTF_EXPORT typeface_cache
+{
+    public:
+    /*
+     * Arrays read by the cache. Counts are numbers of elements. Instead of
+     * a blob, these can be given as constant data, for example written by
+     * the ttf2cpp example program, to compile a font into a program.
+     */
+    struct tables
+    {
+        std::size_t num_glyphs{0};
+        font_metrics metrics{0.0f, 0.0f, 0.0f};
+
+        // Codepoint c maps to cmap_pages[cmap_index[c/256]*256 + c%256]
+        std::uint16_t const * cmap_index{nullptr};
+        std::size_t cmap_index_size{0};
+        std::uint16_t const * cmap_pages{nullptr};
+        std::size_t num_cmap_pages{0};
+
+        // Arrays of left side bearings, advances, x_min, y_min, x_max and
+        // y_max, each num_glyphs long
+        float const * glyph_metrics{nullptr};
+
+        // Pairs are glyph1 << 16 | glyph2, in ascending order
+        std::uint32_t const * kerning_pairs{nullptr};
+        float const * kerning_values{nullptr};
+        std::size_t num_kerning_pairs{0};
+
+        // Same arrays as in outline_store, or nullptr if there are no
+        // outlines. The index has num_glyphs entries.
+        std::uint32_t const * outline_index{nullptr};
+        outline_store::entry const * outline_entries{nullptr};
+        std::size_t num_outline_entries{0};
+        outline_view::coordinate const * points{nullptr};
+        std::size_t num_points{0};
+        std::uint8_t const * on_curve{nullptr};
+        std::size_t num_on_curve_bytes{0};
+        std::uint32_t const * contour_ends{nullptr};
+        std::size_t num_contour_ends{0};
+    };
+
+    typeface_cache() = default;
+    typeface_cache(typeface_cache const &) = default;
+    typeface_cache(typeface_cache &&) = default;
+
+    /*
+     * Only the header and the positions of the arrays are checked here. If
+     * they are not valid, the cache is left empty. The data must be aligned
+     * to four bytes, and stay valid and unmodified as long as the cache is
+     * used. Contents of the arrays are trusted, so the data should come
+     * from serialize of the same version of wttf.
+     */
+    typeface_cache(void const * data, std::size_t size);
+
+    // Nothing is checked, the arrays must be valid as long as the cache is
+    // used
+    constexpr explicit typeface_cache(tables const & t): m_tables{t} {}
+
+    ~typeface_cache() = default;
+
+    typeface_cache & operator=(typeface_cache const &) = default;
+    typeface_cache & operator=(typeface_cache &&) = default;
+
+    /*
+     * Writes the blob of a typeface. Decoded outlines are included only if
+     * with_outlines is true, decoded on up to threads threads (zero for one
+     * per hardware thread). Codepoints above U+FFFF are not included, as
+     * typeface does not map them either.
+     */
+    [[nodiscard]] static std::vector<std::byte> serialize(
+        typeface const & face, bool with_outlines = false,
+        std::size_t threads = 0);
+
+    constexpr explicit operator bool() const
+    {
+        return m_tables.cmap_index != nullptr;
+    }
+
+    [[nodiscard]] tables const & contents() const { return m_tables; }
+
+    [[nodiscard]] std::size_t num_glyphs() const
+    {
+        return m_tables.num_glyphs;
+    }
+
+    [[nodiscard]] std::size_t glyph_index(unsigned int codepoint) const;
+    [[nodiscard]] glyph_metrics metrics(std::uint16_t index) const;
+
+    [[nodiscard]] font_metrics const & metrics() const
+    {
+        return m_tables.metrics;
+    }
+
+    [[nodiscard]] float kerning(
+        std::uint16_t glyph1, std::uint16_t glyph2) const;
+
+    [[nodiscard]] bool has_outlines() const
+    {
+        return m_tables.outline_index != nullptr;
+    }
+
+    // Outline of a glyph, or an empty outline if the blob has no outlines.
+    // Equals the outline returned by typeface::glyph_outline.
+    [[nodiscard]] outline_view glyph_outline(std::uint16_t index) const;
+
+    private:
+    tables m_tables{};
+}; /* class typeface_cache */
+
+} /* namespace wttf */
+
+#endif /* WTTF_TYPEFACE_CACHE_HPP */
@@ -0,0 +1,358 @@
+#ifndef WTTF_BLEND_HPP
+#define WTTF_BLEND_HPP
+
+#include <wttf/paint.hpp>
+#include <wttf/pixel_format.hpp>
+#include "simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+// Source pixel repeated over the span, one byte per channel
+using pattern_t = std::array<std::uint8_t, 4>;
+
+// a*b/255, rounded to nearest. Exact for all 8-bit inputs.
+constexpr std::uint8_t mul_255(unsigned int a, unsigned int b)
+{
+    auto const t = a*b + 128u;
+    return static_cast<std::uint8_t>((t + (t >> 8)) >> 8);
+}
+
+#if WTTF_HAVE_SSE2
+inline __m128i load_16(std::uint8_t const * p)
+{
+    return _mm_loadu_si128(static_cast<__m128i const *>(
+        static_cast<void const *>(p)));
+}
+
+inline void store_16(std::uint8_t * p, __m128i v)
+{
+    _mm_storeu_si128(static_cast<__m128i *>(static_cast<void *>(p)), v);
+}
+
+inline __m128i broadcast(pattern_t const & pattern)
+{
+    auto v = std::int32_t{0};
+    std::memcpy(&v, pattern.data(), sizeof(v));
+    return _mm_set1_epi32(v);
+}
+
+// Same as mul_255 for eight 16-bit lanes
+inline __m128i mul_255_epi16(__m128i a, __m128i b)
+{
+    auto const t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+#endif
+
+/*
+ * Span kernels. They operate on `count` bytes, which must be a multiple of
+ * channel count of the pixel format, so that the pattern stays aligned with
+ * pixels.
+ */
+inline void blend_fill(
+    std::uint8_t * dst, std::size_t count, pattern_t const & src)
+{
+    auto i = std::size_t{0};
+#if WTTF_HAVE_SSE2
+    auto const s = broadcast(src);
+    for(; i+16 <= count; i += 16)
+    {
+        store_16(dst+i, s);
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        dst[i] = src[i & 3];
+    }
+}
+
+inline void blend_max(
+    std::uint8_t * dst, std::size_t count, pattern_t const & src)
+{
+    auto i = std::size_t{0};
+#if WTTF_HAVE_SSE2
+    auto const s = broadcast(src);
+    for(; i+16 <= count; i += 16)
+    {
+        store_16(dst+i, _mm_max_epu8(load_16(dst+i), s));
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        dst[i] = std::max(dst[i], src[i & 3]);
+    }
+}
+
+inline void blend_add(
+    std::uint8_t * dst, std::size_t count, pattern_t const & src)
+{
+    auto i = std::size_t{0};
+#if WTTF_HAVE_SSE2
+    auto const s = broadcast(src);
+    for(; i+16 <= count; i += 16)
+    {
+        store_16(dst+i, _mm_adds_epu8(load_16(dst+i), s));
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        dst[i] = static_cast<std::uint8_t>(std::min(dst[i] + src[i & 3], 0xFF));
+    }
+}
+
+// dst = src + dst * (1 - alpha), src is premultiplied by alpha
+inline void blend_over(
+    std::uint8_t * dst, std::size_t count,
+    pattern_t const & src, std::uint8_t alpha)
+{
+    auto const inv_alpha = static_cast<unsigned int>(0xFF - alpha);
+    auto i = std::size_t{0};
+#if WTTF_HAVE_SSE2
+    auto const zero = _mm_setzero_si128();
+    auto const s = broadcast(src);
+    auto const ia = _mm_set1_epi16(static_cast<short>(inv_alpha));
+    for(; i+16 <= count; i += 16)
+    {
+        auto const d = load_16(dst+i);
+        auto const lo = mul_255_epi16(_mm_unpacklo_epi8(d, zero), ia);
+        auto const hi = mul_255_epi16(_mm_unpackhi_epi8(d, zero), ia);
+        store_16(dst+i, _mm_adds_epu8(_mm_packus_epi16(lo, hi), s));
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        dst[i] = static_cast<std::uint8_t>(
+            std::min(src[i & 3] + mul_255(dst[i], inv_alpha), 0xFF));
+    }
+}
+
+/*
+ * Writes spans of uniform coverage into an image of given pixel format,
+ * combining them with existing pixels as the blend mode says.
+ */
+template <typename Format, blend_mode Mode>
+class span_blender
+{
+    public:
+    using channel_type = typename Format::channel_type;
+    static constexpr blend_mode mode = Mode;
+
+    span_blender(image_view<Format> const & target, paint const & p):
+        m_target{target},
+        m_paint{p},
+        m_plain{
+            p.alpha == 0xFF &&
+            p.color.r == 0xFF && p.color.g == 0xFF && p.color.b == 0xFF}
+    {}
+
+    void operator()(
+        std::size_t y, std::size_t x, std::size_t count,
+        float coverage) const
+    {
+        auto * const dst = pixel(x, y);
+
+        if constexpr(std::is_same_v<channel_type, float>)
+        {
+            write_float(dst, count, coverage);
+        }
+        else
+        {
+            auto const out = std::min(255, static_cast<int>(coverage * 255.0f));
+            write_8bit(dst, count, static_cast<std::uint8_t>(out));
+        }
+    }
+
+    // Span of uniform 8-bit coverage
+    void fill(
+        std::size_t y, std::size_t x, std::size_t count,
+        std::uint8_t coverage) const
+    {
+        auto * const dst = pixel(x, y);
+
+        if constexpr(std::is_same_v<channel_type, float>)
+        {
+            write_float(dst, count, static_cast<float>(coverage) / 255.0f);
+        }
+        else
+        {
+            write_8bit(dst, count, coverage);
+        }
+    }
+
+    /*
+     * Clears rows [y1, y2) of count pixels from x, as spans of no coverage
+     * do in replace mode, with a single memset if the rows are contiguous.
+     */
+    void clear(
+        std::size_t y1, std::size_t y2, std::size_t x,
+        std::size_t count) const
+    {
+        auto const row_size = count * Format::channels * sizeof(channel_type);
+        if(y1 < y2 && m_target.stride == static_cast<std::ptrdiff_t>(row_size))
+        {
+            std::memset(pixel(x, y1), 0, (y2 - y1) * row_size);
+            return;
+        }
+
+        for(auto y = y1; y < y2; ++y)
+        {
+            std::memset(pixel(x, y), 0, row_size);
+        }
+    }
+
+    // Span with 8-bit coverage for each pixel
+    void copy(
+        std::size_t y, std::size_t x, std::size_t count,
+        std::uint8_t const * coverage) const
+    {
+        auto * const dst = pixel(x, y);
+
+        if constexpr(
+            std::is_same_v<Format, pixel_format::a8> &&
+            Mode == blend_mode::replace)
+        {
+            if(m_plain)
+            {
+                std::copy_n(coverage, count, dst);
+                return;
+            }
+        }
+
+        for(auto i = std::size_t{0}; i != count; ++i)
+        {
+            if constexpr(std::is_same_v<channel_type, float>)
+            {
+                write_float(dst+i, 1, static_cast<float>(coverage[i]) / 255.0f);
+            }
+            else
+            {
+                write_8bit(dst + i*Format::channels, 1, coverage[i]);
+            }
+        }
+    }
+
+    private:
+    channel_type * pixel(std::size_t x, std::size_t y) const
+    {
+        auto * const row =
+            static_cast<std::byte *>(static_cast<void *>(m_target.data)) +
+            static_cast<std::ptrdiff_t>(y) * m_target.stride;
+        return
+            static_cast<channel_type *>(static_cast<void *>(row)) +
+            x * Format::channels;
+    }
+
+    void write_8bit(
+        std::uint8_t * dst, std::size_t count, std::uint8_t coverage) const
+    {
+        // Source alpha
+        auto const a =
+            m_plain ? coverage : mul_255(coverage, m_paint.alpha);
+
+        if constexpr(Mode != blend_mode::replace)
+        {
+            if(a == 0)
+                return;
+        }
+
+        auto const src = source_pattern(a);
+
+        if constexpr(Mode == blend_mode::replace && Format::channels == 1)
+        {
+            std::fill_n(dst, count, src[0]);
+        }
+        else if constexpr(Mode == blend_mode::replace)
+        {
+            blend_fill(dst, count * Format::channels, src);
+        }
+        else if constexpr(Mode == blend_mode::max)
+        {
+            blend_max(dst, count * Format::channels, src);
+        }
+        else if constexpr(Mode == blend_mode::add)
+        {
+            blend_add(dst, count * Format::channels, src);
+        }
+        else
+        {
+            blend_over(dst, count * Format::channels, src, a);
+        }
+    }
+
+    pattern_t source_pattern(std::uint8_t a) const
+    {
+        auto const & c = m_paint.color;
+
+        if constexpr(std::is_same_v<Format, pixel_format::rgba8>)
+        {
+            return {mul_255(a, c.r), mul_255(a, c.g), mul_255(a, c.b), a};
+        }
+        else if constexpr(std::is_same_v<Format, pixel_format::bgra8>)
+        {
+            return {mul_255(a, c.b), mul_255(a, c.g), mul_255(a, c.r), a};
+        }
+        else
+        {
+            auto const v = m_plain ? a : mul_255(a, c.luminance());
+            return {v, v, v, v};
+        }
+    }
+
+    void write_float(float * dst, std::size_t count, float coverage) const
+    {
+        auto const a =
+            m_plain ?
+            coverage :
+            coverage * static_cast<float>(m_paint.alpha) / 255.0f;
+        auto const v =
+            m_plain ?
+            a :
+            a * static_cast<float>(m_paint.color.luminance()) / 255.0f;
+
+        if constexpr(Mode == blend_mode::replace)
+        {
+            std::fill_n(dst, count, v);
+            return;
+        }
+
+        if(a == 0.0f)
+            return;
+
+        for(auto i = std::size_t{0}; i != count; ++i)
+        {
+            if constexpr(Mode == blend_mode::max)
+            {
+                dst[i] = std::max(dst[i], v);
+            }
+            else if constexpr(Mode == blend_mode::add)
+            {
+                dst[i] = std::min(dst[i] + v, 1.0f);
+            }
+            else
+            {
+                dst[i] = v + dst[i] * (1.0f - a);
+            }
+        }
+    }
+
+    image_view<Format> m_target;
+    paint m_paint;
+    bool m_plain;
+};
+
+} /* namespace detail */
+
+} /* namespace wttf */
+
+#endif /* WTTF_BLEND_HPP */
@@ -0,0 +1,242 @@
+#include "coverage_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#if defined(_MSC_VER) && !defined(__clang__) && \
+    (WTTF_HAVE_SSE41_KERNEL || WTTF_HAVE_AVX2_KERNEL)
+#include <intrin.h>
+#endif
+
+namespace wttf
+{
+
+namespace detail
+{
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#if WTTF_HAVE_SSE41_KERNEL
+bool cpu_has_sse41()
+{
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[2] & (1 << 19)) != 0;
+}
+#endif
+
+#if WTTF_HAVE_AVX2_KERNEL
+bool cpu_has_avx2()
+{
+    int regs[4];
+    __cpuid(regs, 0);
+    if(regs[0] < 7)
+        return false;
+
+    // OS must save the AVX registers on context switch
+    __cpuid(regs, 1);
+    auto const osxsave = (regs[2] & (1 << 27)) != 0;
+    auto const avx = (regs[2] & (1 << 28)) != 0;
+    if(!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+}
+#endif
+#else
+#if WTTF_HAVE_SSE41_KERNEL
+bool cpu_has_sse41()
+{
+    return __builtin_cpu_supports("sse4.1");
+}
+#endif
+
+#if WTTF_HAVE_AVX2_KERNEL
+bool cpu_has_avx2()
+{
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+#endif
+
+std::int32_t resolve_area_scalar(
+    std::int32_t * acc, std::int32_t * out, std::size_t count,
+    std::int32_t sum, std::int32_t full, bool even_odd)
+{
+    for(auto i = std::size_t{0}; i != count; ++i)
+    {
+        sum += acc[i];
+        acc[i] = 0;
+
+        auto const a = std::abs(sum);
+        if(even_odd)
+        {
+            auto const m = a & (2*full - 1);
+            out[i] = m > full ? 2*full - m : m;
+        }
+        else
+        {
+            out[i] = std::min(a, full);
+        }
+    }
+
+    return sum;
+}
+
+namespace
+{
+
+/*
+ * Area a scanline edge covers of pixel x, which is not right of the edge.
+ * Same float math as edge_info::coverage of the floating-point engine, which
+ * computes short runs itself.
+ */
+float edge_coverage(scanline_edge const & e, float const x)
+{
+    if(x+1.0f < e.x1)
+        return 0.0f;
+
+    auto const tdx = e.x2-e.x1;
+    if(tdx < std::numeric_limits<float>::epsilon())
+    {
+        return e.winding_height * ((x+1.0f) - e.x2);
+    }
+
+    auto const ix1 = std::clamp(x, e.x1, e.x2);
+    auto const ix2 = std::clamp(x+1.0f, e.x1, e.x2);
+    auto const dx1 = ix2-ix1;
+    auto const dx2 = (x+1.0f)-ix2;
+    auto const h1 = e.winding_height * (ix1 - e.x1)/tdx;
+    auto const h2 = e.winding_height * (ix2 - e.x1)/tdx;
+    auto const avg_h = (h1+h2) / 2.0f;
+    return (avg_h*dx1) + (e.winding_height*dx2);
+}
+
+enum class instruction_set
+{
+    scalar,
+    sse41,
+    avx2
+};
+
+instruction_set detect_instruction_set()
+{
+    static auto const set = []()
+    {
+#if WTTF_HAVE_AVX2_KERNEL
+        if(cpu_has_avx2())
+            return instruction_set::avx2;
+#endif
+#if WTTF_HAVE_SSE41_KERNEL
+        if(cpu_has_sse41())
+            return instruction_set::sse41;
+#endif
+        return instruction_set::scalar;
+    }();
+
+    return set;
+}
+
+} /* namespace */
+
+void resolve_scanline_scalar(
+    scanline_edge const * edges, std::size_t num_edges,
+    std::size_t x, std::size_t count, float sum, bool even_odd, float * out)
+{
+    for(auto i = std::size_t{0}; i != count; ++i)
+    {
+        auto const fx = static_cast<float>(x+i);
+
+        auto passed = sum;
+        auto crossing = 0.0f;
+        for(auto j = std::size_t{0}; j != num_edges; ++j)
+        {
+            if(fx > edges[j].x2)
+            {
+                passed += edges[j].winding_height;
+            }
+            else
+            {
+                crossing += edge_coverage(edges[j], fx);
+            }
+        }
+
+        auto const area = passed + crossing;
+        if(even_odd)
+        {
+            auto const a = std::fmod(std::abs(area), 2.0f);
+            out[i] = a > 1.0f ? 2.0f - a : a;
+        }
+        else
+        {
+            out[i] = std::clamp(std::abs(area), 0.0f, 1.0f);
+        }
+    }
+}
+
+void coverage_to_8bit_scalar(
+    float const * coverage, std::uint8_t * out, std::size_t count)
+{
+    for(auto i = std::size_t{0}; i != count; ++i)
+    {
+        out[i] = static_cast<std::uint8_t>(
+            std::min(255, static_cast<int>(coverage[i] * 255.0f)));
+    }
+}
+
+resolve_area_fn resolve_area_kernel()
+{
+    switch(detect_instruction_set())
+    {
+#if WTTF_HAVE_AVX2_KERNEL
+        case instruction_set::avx2:
+            return resolve_area_avx2;
+#endif
+#if WTTF_HAVE_SSE41_KERNEL
+        case instruction_set::sse41:
+            return resolve_area_sse41;
+#endif
+        default:
+            return resolve_area_scalar;
+    }
+}
+
+resolve_scanline_fn resolve_scanline_kernel()
+{
+    switch(detect_instruction_set())
+    {
+#if WTTF_HAVE_AVX2_KERNEL
+        case instruction_set::avx2:
+            return resolve_scanline_avx2;
+#endif
+#if WTTF_HAVE_SSE41_KERNEL
+        case instruction_set::sse41:
+            return resolve_scanline_sse41;
+#endif
+        default:
+            return resolve_scanline_scalar;
+    }
+}
+
+coverage_to_8bit_fn coverage_to_8bit_kernel()
+{
+    switch(detect_instruction_set())
+    {
+#if WTTF_HAVE_AVX2_KERNEL
+        case instruction_set::avx2:
+            return coverage_to_8bit_avx2;
+#endif
+#if WTTF_HAVE_SSE41_KERNEL
+        case instruction_set::sse41:
+            return coverage_to_8bit_sse41;
+#endif
+        default:
+            return coverage_to_8bit_scalar;
+    }
+}
+
+} /* namespace detail */
+
+} /* namespace wttf */
@@ -0,0 +1,120 @@
+#ifndef WTTF_COVERAGE_KERNEL_HPP
+#define WTTF_COVERAGE_KERNEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+/*
+ * Resolves a row of accumulated signed area into coverage. Value of each
+ * pixel is the running sum of acc, starting from sum, folded with non-zero
+ * or even-odd fill rule into range [0, full]. Full is the area of a whole
+ * pixel and must be a power of two. Clears acc and returns the running sum
+ * after the last pixel.
+ *
+ * All implementations give identical output, which coverage_kernel_check
+ * verifies. This header is included in translation units compiled for newer
+ * instruction sets, so it must not pull in any inline functions that are
+ * used elsewhere.
+ *
+ * Of the fixed-point engines, only the resolve is vectorized. Accumulating
+ * the area of an edge walks the cells it crosses one by one, adding into
+ * pixels in an order that depends on the edge, which does not map onto
+ * vector lanes.
+ */
+using resolve_area_fn = std::int32_t (*)(
+    std::int32_t * acc, std::int32_t * out, std::size_t count,
+    std::int32_t sum, std::int32_t full, bool even_odd);
+
+std::int32_t resolve_area_scalar(
+    std::int32_t * acc, std::int32_t * out, std::size_t count,
+    std::int32_t sum, std::int32_t full, bool even_odd);
+
+#if WTTF_HAVE_SSE41_KERNEL
+bool cpu_has_sse41();
+
+std::int32_t resolve_area_sse41(
+    std::int32_t * acc, std::int32_t * out, std::size_t count,
+    std::int32_t sum, std::int32_t full, bool even_odd);
+#endif
+
+#if WTTF_HAVE_AVX2_KERNEL
+bool cpu_has_avx2();
+
+std::int32_t resolve_area_avx2(
+    std::int32_t * acc, std::int32_t * out, std::size_t count,
+    std::int32_t sum, std::int32_t full, bool even_odd);
+#endif
+
+/*
+ * Edge of the floating-point engine clipped to one scanline: it crosses
+ * pixels from x1 to x2, and each pixel right of it is covered by
+ * winding_height.
+ */
+struct scanline_edge
+{
+    float x1;
+    float x2;
+    float winding_height;
+};
+
+/*
+ * Resolves coverage of count pixels of a scanline of the floating-point
+ * engine, starting from pixel x. Area of each pixel is sum, plus the winding
+ * height of the edges left of it, plus the area the edges crossing it cover,
+ * folded with non-zero or even-odd fill rule into range [0, 1].
+ *
+ * Edges are in order of x2, and are all the edges not left of x, except
+ * those starting right of the last pixel, which would add nothing. Sum
+ * is the area of the edges left of x. Lanes are pixels, and each lane adds
+ * up the edges in the same order and with the same float operations as the
+ * scalar implementation, so that the output is identical.
+ */
+using resolve_scanline_fn = void (*)(
+    scanline_edge const * edges, std::size_t num_edges,
+    std::size_t x, std::size_t count, float sum, bool even_odd, float * out);
+
+// Converts coverage in range [0, 1] to 8 bits, rounding down
+using coverage_to_8bit_fn = void (*)(
+    float const * coverage, std::uint8_t * out, std::size_t count);
+
+void resolve_scanline_scalar(
+    scanline_edge const * edges, std::size_t num_edges,
+    std::size_t x, std::size_t count, float sum, bool even_odd, float * out);
+
+void coverage_to_8bit_scalar(
+    float const * coverage, std::uint8_t * out, std::size_t count);
+
+#if WTTF_HAVE_SSE41_KERNEL
+void resolve_scanline_sse41(
+    scanline_edge const * edges, std::size_t num_edges,
+    std::size_t x, std::size_t count, float sum, bool even_odd, float * out);
+
+void coverage_to_8bit_sse41(
+    float const * coverage, std::uint8_t * out, std::size_t count);
+#endif
+
+#if WTTF_HAVE_AVX2_KERNEL
+void resolve_scanline_avx2(
+    scanline_edge const * edges, std::size_t num_edges,
+    std::size_t x, std::size_t count, float sum, bool even_odd, float * out);
+
+void coverage_to_8bit_avx2(
+    float const * coverage, std::uint8_t * out, std::size_t count);
+#endif
+
+// Fastest implementations the CPU supports, detected on the first call
+resolve_area_fn resolve_area_kernel();
+resolve_scanline_fn resolve_scanline_kernel();
+coverage_to_8bit_fn coverage_to_8bit_kernel();
+
+} /* namespace detail */
+
+} /* namespace wttf */
+
+#endif /* WTTF_COVERAGE_KERNEL_HPP */
@@ -0,0 +1,226 @@
+// Compiled with AVX2 enabled. Used only when the CPU supports it.
+#include "coverage_kernel.hpp"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+namespace
+{
+
+__m256i load(std::int32_t const * p)
+{
+    return _mm256_loadu_si256(static_cast<__m256i const *>(
+        static_cast<void const *>(p)));
+}
+
+void store(std::int32_t * p, __m256i v)
+{
+    _mm256_storeu_si256(static_cast<__m256i *>(static_cast<void *>(p)), v);
+}
+
+template <bool EvenOdd>
+std::int32_t resolve(
+    std::int32_t * acc, std::int32_t * out, std::size_t count,
+    std::int32_t sum, std::int32_t full)
+{
+    auto const zero = _mm256_setzero_si256();
+    auto const full_v = _mm256_set1_epi32(full);
+    auto const double_full = _mm256_set1_epi32(2*full);
+    auto const mask = _mm256_set1_epi32(2*full - 1);
+    auto const last = _mm256_set1_epi32(7);
+    auto carry = _mm256_set1_epi32(sum);
+
+    auto i = std::size_t{0};
+    for(; i+8 <= count; i += 8)
+    {
+        // Prefix sum within both 128-bit halves, then carry the sum of the
+        // lower half over to the upper one
+        auto x = load(acc+i);
+        store(acc+i, zero);
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        auto const low_sum = _mm_shuffle_epi32(
+            _mm256_castsi256_si128(x), _MM_SHUFFLE(3, 3, 3, 3));
+        x = _mm256_add_epi32(
+            x, _mm256_inserti128_si256(zero, low_sum, 1));
+        x = _mm256_add_epi32(x, carry);
+        carry = _mm256_permutevar8x32_epi32(x, last);
+
+        auto a = _mm256_abs_epi32(x);
+        if constexpr(EvenOdd)
+        {
+            auto const m = _mm256_and_si256(a, mask);
+            a = _mm256_min_epi32(m, _mm256_sub_epi32(double_full, m));
+        }
+        else
+        {
+            a = _mm256_min_epi32(a, full_v);
+        }
+
+        store(out+i, a);
+    }
+
+    return resolve_area_scalar(
+        acc+i, out+i, count-i,
+        _mm_cvtsi128_si32(_mm256_castsi256_si128(carry)), full, EvenOdd);
+}
+
+// std::clamp with its exact choice of bounds for equal and signed zero values
+__m256 clamp(__m256 v, __m256 lo, __m256 hi)
+{
+    auto const r = _mm256_blendv_ps(v, hi, _mm256_cmp_ps(hi, v, _CMP_LT_OQ));
+    return _mm256_blendv_ps(r, lo, _mm256_cmp_ps(v, lo, _CMP_LT_OQ));
+}
+
+// Area an edge covers of pixels x, which are not right of it
+__m256 edge_coverage(scanline_edge const & e, __m256 x, __m256 x_end)
+{
+    auto const x1 = _mm256_set1_ps(e.x1);
+    auto const x2 = _mm256_set1_ps(e.x2);
+    auto const h = _mm256_set1_ps(e.winding_height);
+
+    auto coverage = __m256{};
+    auto const tdx = e.x2-e.x1;
+    if(tdx < std::numeric_limits<float>::epsilon())
+    {
+        coverage = _mm256_mul_ps(h, _mm256_sub_ps(x_end, x2));
+    }
+    else
+    {
+        auto const t = _mm256_set1_ps(tdx);
+        auto const ix1 = clamp(x, x1, x2);
+        auto const ix2 = clamp(x_end, x1, x2);
+        auto const dx1 = _mm256_sub_ps(ix2, ix1);
+        auto const dx2 = _mm256_sub_ps(x_end, ix2);
+        auto const h1 = _mm256_div_ps(
+            _mm256_mul_ps(h, _mm256_sub_ps(ix1, x1)), t);
+        auto const h2 = _mm256_div_ps(
+            _mm256_mul_ps(h, _mm256_sub_ps(ix2, x1)), t);
+        auto const avg_h = _mm256_div_ps(
+            _mm256_add_ps(h1, h2), _mm256_set1_ps(2.0f));
+        coverage = _mm256_add_ps(
+            _mm256_mul_ps(avg_h, dx1), _mm256_mul_ps(h, dx2));
+    }
+
+    // Pixels left of the edge
+    return _mm256_andnot_ps(_mm256_cmp_ps(x_end, x1, _CMP_LT_OQ), coverage);
+}
+
+template <bool EvenOdd>
+void resolve_scanline(
+    scanline_edge const * edges, std::size_t num_edges,
+    std::size_t x, std::size_t count, float sum, float * out)
+{
+    auto const one = _mm256_set1_ps(1.0f);
+    auto const two = _mm256_set1_ps(2.0f);
+    auto const sign = _mm256_set1_ps(-0.0f);
+    auto const lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    // Pixels past count in the last block are resolved too and dropped, as
+    // lanes do not depend on each other
+    for(auto i = std::size_t{0}; i < count; i += 8)
+    {
+        auto const px = _mm256_cvtepi32_ps(_mm256_add_epi32(
+            _mm256_set1_epi32(static_cast<int>(x+i)), lanes));
+        auto const px_end = _mm256_add_ps(px, one);
+
+        // Lanes an edge does not apply to add +0, which changes no sum
+        auto passed = _mm256_set1_ps(sum);
+        auto crossing = _mm256_setzero_ps();
+        for(auto j = std::size_t{0}; j != num_edges; ++j)
+        {
+            auto const left = _mm256_cmp_ps(
+                px, _mm256_set1_ps(edges[j].x2), _CMP_GT_OQ);
+            passed = _mm256_add_ps(passed, _mm256_and_ps(
+                left, _mm256_set1_ps(edges[j].winding_height)));
+            crossing = _mm256_add_ps(crossing, _mm256_andnot_ps(
+                left, edge_coverage(edges[j], px, px_end)));
+        }
+
+        auto a = _mm256_andnot_ps(sign, _mm256_add_ps(passed, crossing));
+        if constexpr(EvenOdd)
+        {
+            a = _mm256_sub_ps(a, _mm256_mul_ps(
+                two, _mm256_floor_ps(_mm256_div_ps(a, two))));
+            a = _mm256_blendv_ps(
+                a, _mm256_sub_ps(two, a), _mm256_cmp_ps(a, one, _CMP_GT_OQ));
+        }
+        else
+        {
+            a = _mm256_blendv_ps(a, one, _mm256_cmp_ps(one, a, _CMP_LT_OQ));
+        }
+
+        if(i+8 <= count)
+        {
+            _mm256_storeu_ps(out+i, a);
+        }
+        else
+        {
+            float last[8];
+            _mm256_storeu_ps(last, a);
+            std::copy_n(last, count-i, out+i);
+        }
+    }
+}
+
+} /* namespace */
+
+std::int32_t resolve_area_avx2(
+    std::int32_t * acc, std::int32_t * out, std::size_t count,
+    std::int32_t sum, std::int32_t full, bool even_odd)
+{
+    return even_odd ?
+        resolve<true>(acc, out, count, sum, full) :
+        resolve<false>(acc, out, count, sum, full);
+}
+
+void resolve_scanline_avx2(
+    scanline_edge const * edges, std::size_t num_edges,
+    std::size_t x, std::size_t count, float sum, bool even_odd, float * out)
+{
+    if(even_odd)
+    {
+        resolve_scanline<true>(edges, num_edges, x, count, sum, out);
+    }
+    else
+    {
+        resolve_scanline<false>(edges, num_edges, x, count, sum, out);
+    }
+}
+
+void coverage_to_8bit_avx2(
+    float const * coverage, std::uint8_t * out, std::size_t count)
+{
+    auto const scale = _mm256_set1_ps(255.0f);
+    auto const convert = [&](std::size_t i)
+    {
+        // Packs the 32-bit lanes of both halves into 16 bits
+        auto const v = _mm256_cvttps_epi32(
+            _mm256_mul_ps(_mm256_loadu_ps(coverage+i), scale));
+        return _mm_packs_epi32(
+            _mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    };
+
+    // Packing saturates to 255, like std::min
+    auto i = std::size_t{0};
+    for(; i+16 <= count; i += 16)
+    {
+        _mm_storeu_si128(
+            static_cast<__m128i *>(static_cast<void *>(out+i)),
+            _mm_packus_epi16(convert(i), convert(i+8)));
+    }
+
+    coverage_to_8bit_scalar(coverage+i, out+i, count-i);
+}
+
+} /* namespace detail */
+
+} /* namespace wttf */
@@ -0,0 +1,280 @@
+/*
+ * Compares the vectorized coverage kernels with the scalar ones on random
+ * rows and scanlines, for both fill rules and for lengths, which are not
+ * multiples of the vector width. Float output must be identical bit for
+ * bit. Kernels the CPU does not support are skipped. Run by ctest,
+ * exits with non-zero status on the first mismatch.
+ */
+#include "coverage_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+using namespace wttf::detail;
+
+struct kernel
+{
+    char const * name;
+    resolve_area_fn resolve_area;
+    resolve_scanline_fn resolve_scanline;
+    coverage_to_8bit_fn coverage_to_8bit;
+};
+
+std::vector<kernel> supported_kernels()
+{
+    auto kernels = std::vector<kernel>{};
+#if WTTF_HAVE_SSE41_KERNEL
+    if(cpu_has_sse41())
+        kernels.push_back({
+            "sse4.1", resolve_area_sse41, resolve_scanline_sse41,
+            coverage_to_8bit_sse41});
+    else
+        std::cout << "sse4.1 not supported by the CPU, skipped\n";
+#endif
+#if WTTF_HAVE_AVX2_KERNEL
+    if(cpu_has_avx2())
+        kernels.push_back({
+            "avx2", resolve_area_avx2, resolve_scanline_avx2,
+            coverage_to_8bit_avx2});
+    else
+        std::cout << "avx2 not supported by the CPU, skipped\n";
+#endif
+    return kernels;
+}
+
+/*
+ * Row of accumulated area, like the rasterizer writes: mostly zeros, with
+ * cells of up to a few times full on both sides of zero, so that the
+ * running sum crosses all the folds of both fill rules.
+ */
+std::vector<std::int32_t> random_row(
+    std::mt19937 & rng, std::size_t count, std::int32_t full)
+{
+    auto cell = std::uniform_int_distribution<std::int32_t>{-3*full, 3*full};
+    auto used = std::bernoulli_distribution{0.3};
+
+    auto row = std::vector<std::int32_t>(count);
+    for(auto & a: row)
+    {
+        a = used(rng) ? cell(rng) : 0;
+    }
+
+    return row;
+}
+
+bool check(
+    kernel const & k, std::vector<std::int32_t> const & row,
+    std::int32_t sum, std::int32_t full, bool even_odd)
+{
+    auto const count = row.size();
+
+    auto expected_acc = row;
+    auto expected = std::vector<std::int32_t>(count);
+    auto const expected_sum = resolve_area_scalar(
+        expected_acc.data(), expected.data(), count, sum, full, even_odd);
+
+    auto acc = row;
+    auto out = std::vector<std::int32_t>(count);
+    auto const result_sum =
+        k.resolve_area(acc.data(), out.data(), count, sum, full, even_odd);
+
+    if(out == expected && acc == expected_acc && result_sum == expected_sum)
+        return true;
+
+    std::cerr <<
+        k.name << ": mismatch with " << count << " pixels, " <<
+        (even_odd ? "even-odd" : "non-zero") << " fill rule, full " <<
+        full << ", starting sum " << sum << "\n";
+    return false;
+}
+
+/*
+ * Edges of a scanline, like the floating-point engine clips them: sorted by
+ * x2, some vertical or nearly so, some on pixel boundaries, with winding
+ * heights of up to a whole pixel in both directions.
+ */
+std::vector<scanline_edge> random_scanline(
+    std::mt19937 & rng, std::size_t num_edges, float width)
+{
+    auto x = std::uniform_real_distribution<float>{-2.0f, width + 2.0f};
+    auto dx = std::uniform_real_distribution<float>{0.0f, 6.0f};
+    auto height = std::uniform_real_distribution<float>{-1.0f, 1.0f};
+    auto kind = std::uniform_int_distribution<int>{0, 3};
+
+    auto edges = std::vector<scanline_edge>(num_edges);
+    for(auto & e: edges)
+    {
+        e.x1 = x(rng);
+        switch(kind(rng))
+        {
+            case 0:
+                e.x2 = e.x1;
+                break;
+            case 1:
+                e.x2 = e.x1 + 1e-7f;
+                break;
+            case 2:
+                e.x1 = std::floor(e.x1);
+                e.x2 = e.x1 + std::floor(dx(rng));
+                break;
+            default:
+                e.x2 = e.x1 + dx(rng);
+                break;
+        }
+        e.winding_height = height(rng);
+    }
+
+    std::sort(
+        edges.begin(), edges.end(),
+        [](auto const & a, auto const & b) { return a.x2 < b.x2; });
+    return edges;
+}
+
+bool check_scanline(
+    kernel const & k, std::vector<scanline_edge> const & edges,
+    std::size_t x, std::size_t count, float sum, bool even_odd)
+{
+    auto expected = std::vector<float>(count);
+    resolve_scanline_scalar(
+        edges.data(), edges.size(), x, count, sum, even_odd,
+        expected.data());
+
+    auto out = std::vector<float>(count);
+    k.resolve_scanline(
+        edges.data(), edges.size(), x, count, sum, even_odd, out.data());
+
+    // Bit for bit, telling apart signed zeros
+    if(count == 0 ||
+        std::memcmp(out.data(), expected.data(), count * sizeof(float)) == 0)
+    {
+        return true;
+    }
+
+    std::cerr <<
+        k.name << ": mismatch with " << edges.size() << " edges, " <<
+        count << " pixels from " << x << ", " <<
+        (even_odd ? "even-odd" : "non-zero") << " fill rule, starting sum " <<
+        sum << "\n";
+    return false;
+}
+
+bool check_8bit(kernel const & k, std::vector<float> const & coverage)
+{
+    auto const count = coverage.size();
+
+    auto expected = std::vector<std::uint8_t>(count);
+    coverage_to_8bit_scalar(coverage.data(), expected.data(), count);
+
+    auto out = std::vector<std::uint8_t>(count);
+    k.coverage_to_8bit(coverage.data(), out.data(), count);
+
+    if(out == expected)
+        return true;
+
+    std::cerr <<
+        k.name << ": mismatch in 8-bit coverage of " << count << " pixels\n";
+    return false;
+}
+
+} /* namespace */
+
+int main()
+{
+    auto const kernels = supported_kernels();
+    auto rng = std::mt19937{20260};
+    auto const fulls = {std::int32_t{2}, std::int32_t{256}, std::int32_t{131072}};
+
+    auto lengths = std::vector<std::size_t>{};
+    for(auto n = std::size_t{0}; n != 70; ++n)
+    {
+        lengths.push_back(n);
+    }
+    lengths.insert(lengths.end(), {255, 257, 1001, 4099});
+
+    auto runs = 0u;
+    for(auto const & k: kernels)
+    {
+        for(auto const count: lengths)
+        {
+            for(auto const full: fulls)
+            {
+                for(auto const even_odd: {false, true})
+                {
+                    for(auto i = 0; i != 20; ++i)
+                    {
+                        auto const row = random_row(rng, count, full);
+                        auto const sum = i % 2 ?
+                            std::uniform_int_distribution<std::int32_t>{
+                                -2*full, 2*full}(rng) :
+                            0;
+
+                        if(!check(k, row, sum, full, even_odd))
+                            return 1;
+
+                        ++runs;
+                    }
+                }
+            }
+        }
+    }
+
+    auto scanlines = 0u;
+    for(auto const & k: kernels)
+    {
+        for(auto const count: lengths)
+        {
+            for(auto const even_odd: {false, true})
+            {
+                for(auto i = 0; i != 10; ++i)
+                {
+                    auto const num_edges = std::size_t(i*i);
+                    auto const x = std::size_t(i*7);
+                    auto const edges = random_scanline(
+                        rng, num_edges, static_cast<float>(x + count));
+                    auto const sum = i % 2 ?
+                        std::uniform_real_distribution<float>{-3.0f, 3.0f}(rng) :
+                        0.0f;
+
+                    if(!check_scanline(k, edges, x, count, sum, even_odd))
+                        return 1;
+
+                    ++scanlines;
+                }
+            }
+
+            // Coverage as resolved, with exact multiples of 1/255 and the
+            // ends of the range among it
+            auto value = std::uniform_real_distribution<float>{0.0f, 1.0f};
+            auto step = std::uniform_int_distribution<int>{0, 255};
+            auto coverage = std::vector<float>(count);
+            for(auto j = std::size_t{0}; j != count; ++j)
+            {
+                coverage[j] = j % 3 ?
+                    value(rng) :
+                    static_cast<float>(step(rng)) / 255.0f;
+            }
+            if(count > 1)
+            {
+                coverage.front() = 1.0f;
+                coverage.back() = 0.0f;
+            }
+
+            if(!check_8bit(k, coverage))
+                return 1;
+        }
+    }
+
+    std::cout <<
+        "scalar and " << kernels.size() << " vectorized kernels agree on " <<
+        runs << " rows and " << scanlines << " scanlines\n";
+    return 0;
+}
@@ -0,0 +1,216 @@
+// Compiled with SSE4.1 enabled. Used only when the CPU supports it.
+#include "coverage_kernel.hpp"
+
+#include <smmintrin.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+namespace
+{
+
+__m128i load(std::int32_t const * p)
+{
+    return _mm_loadu_si128(static_cast<__m128i const *>(
+        static_cast<void const *>(p)));
+}
+
+void store(std::int32_t * p, __m128i v)
+{
+    _mm_storeu_si128(static_cast<__m128i *>(static_cast<void *>(p)), v);
+}
+
+template <bool EvenOdd>
+std::int32_t resolve(
+    std::int32_t * acc, std::int32_t * out, std::size_t count,
+    std::int32_t sum, std::int32_t full)
+{
+    auto const zero = _mm_setzero_si128();
+    auto const full_v = _mm_set1_epi32(full);
+    auto const double_full = _mm_set1_epi32(2*full);
+    auto const mask = _mm_set1_epi32(2*full - 1);
+    auto carry = _mm_set1_epi32(sum);
+
+    auto i = std::size_t{0};
+    for(; i+4 <= count; i += 4)
+    {
+        // Prefix sum of four lanes
+        auto x = load(acc+i);
+        store(acc+i, zero);
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+
+        auto a = _mm_abs_epi32(x);
+        if constexpr(EvenOdd)
+        {
+            // min(m, 2*full - m) folds the winding parity
+            auto const m = _mm_and_si128(a, mask);
+            a = _mm_min_epi32(m, _mm_sub_epi32(double_full, m));
+        }
+        else
+        {
+            a = _mm_min_epi32(a, full_v);
+        }
+
+        store(out+i, a);
+    }
+
+    return resolve_area_scalar(
+        acc+i, out+i, count-i, _mm_cvtsi128_si32(carry), full, EvenOdd);
+}
+
+// std::clamp with its exact choice of bounds for equal and signed zero values
+__m128 clamp(__m128 v, __m128 lo, __m128 hi)
+{
+    auto const r = _mm_blendv_ps(v, hi, _mm_cmplt_ps(hi, v));
+    return _mm_blendv_ps(r, lo, _mm_cmplt_ps(v, lo));
+}
+
+// Area an edge covers of pixels x, which are not right of it
+__m128 edge_coverage(scanline_edge const & e, __m128 x, __m128 x_end)
+{
+    auto const x1 = _mm_set1_ps(e.x1);
+    auto const x2 = _mm_set1_ps(e.x2);
+    auto const h = _mm_set1_ps(e.winding_height);
+
+    auto coverage = __m128{};
+    auto const tdx = e.x2-e.x1;
+    if(tdx < std::numeric_limits<float>::epsilon())
+    {
+        coverage = _mm_mul_ps(h, _mm_sub_ps(x_end, x2));
+    }
+    else
+    {
+        auto const t = _mm_set1_ps(tdx);
+        auto const ix1 = clamp(x, x1, x2);
+        auto const ix2 = clamp(x_end, x1, x2);
+        auto const dx1 = _mm_sub_ps(ix2, ix1);
+        auto const dx2 = _mm_sub_ps(x_end, ix2);
+        auto const h1 = _mm_div_ps(_mm_mul_ps(h, _mm_sub_ps(ix1, x1)), t);
+        auto const h2 = _mm_div_ps(_mm_mul_ps(h, _mm_sub_ps(ix2, x1)), t);
+        auto const avg_h = _mm_div_ps(_mm_add_ps(h1, h2), _mm_set1_ps(2.0f));
+        coverage = _mm_add_ps(_mm_mul_ps(avg_h, dx1), _mm_mul_ps(h, dx2));
+    }
+
+    // Pixels left of the edge
+    return _mm_andnot_ps(_mm_cmplt_ps(x_end, x1), coverage);
+}
+
+template <bool EvenOdd>
+void resolve_scanline(
+    scanline_edge const * edges, std::size_t num_edges,
+    std::size_t x, std::size_t count, float sum, float * out)
+{
+    auto const one = _mm_set1_ps(1.0f);
+    auto const two = _mm_set1_ps(2.0f);
+    auto const sign = _mm_set1_ps(-0.0f);
+    auto const lanes = _mm_setr_epi32(0, 1, 2, 3);
+
+    // Pixels past count in the last block are resolved too and dropped, as
+    // lanes do not depend on each other
+    for(auto i = std::size_t{0}; i < count; i += 4)
+    {
+        auto const px = _mm_cvtepi32_ps(_mm_add_epi32(
+            _mm_set1_epi32(static_cast<int>(x+i)), lanes));
+        auto const px_end = _mm_add_ps(px, one);
+
+        // Edges left of a pixel add their winding height, others the area
+        // they cover. Lanes they do not apply to add +0, which changes no
+        // sum.
+        auto passed = _mm_set1_ps(sum);
+        auto crossing = _mm_setzero_ps();
+        for(auto j = std::size_t{0}; j != num_edges; ++j)
+        {
+            auto const left =
+                _mm_cmpgt_ps(px, _mm_set1_ps(edges[j].x2));
+            passed = _mm_add_ps(passed, _mm_and_ps(
+                left, _mm_set1_ps(edges[j].winding_height)));
+            crossing = _mm_add_ps(crossing, _mm_andnot_ps(
+                left, edge_coverage(edges[j], px, px_end)));
+        }
+
+        auto a = _mm_andnot_ps(sign, _mm_add_ps(passed, crossing));
+        if constexpr(EvenOdd)
+        {
+            // Remainder of division by two is exact, like std::fmod
+            a = _mm_sub_ps(a, _mm_mul_ps(
+                two, _mm_floor_ps(_mm_div_ps(a, two))));
+            a = _mm_blendv_ps(a, _mm_sub_ps(two, a), _mm_cmpgt_ps(a, one));
+        }
+        else
+        {
+            a = _mm_blendv_ps(a, one, _mm_cmplt_ps(one, a));
+        }
+
+        if(i+4 <= count)
+        {
+            _mm_storeu_ps(out+i, a);
+        }
+        else
+        {
+            float last[4];
+            _mm_storeu_ps(last, a);
+            std::copy_n(last, count-i, out+i);
+        }
+    }
+}
+
+} /* namespace */
+
+std::int32_t resolve_area_sse41(
+    std::int32_t * acc, std::int32_t * out, std::size_t count,
+    std::int32_t sum, std::int32_t full, bool even_odd)
+{
+    return even_odd ?
+        resolve<true>(acc, out, count, sum, full) :
+        resolve<false>(acc, out, count, sum, full);
+}
+
+void resolve_scanline_sse41(
+    scanline_edge const * edges, std::size_t num_edges,
+    std::size_t x, std::size_t count, float sum, bool even_odd, float * out)
+{
+    if(even_odd)
+    {
+        resolve_scanline<true>(edges, num_edges, x, count, sum, out);
+    }
+    else
+    {
+        resolve_scanline<false>(edges, num_edges, x, count, sum, out);
+    }
+}
+
+void coverage_to_8bit_sse41(
+    float const * coverage, std::uint8_t * out, std::size_t count)
+{
+    auto const scale = _mm_set1_ps(255.0f);
+    auto const convert = [&](std::size_t i)
+    {
+        return _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(coverage+i), scale));
+    };
+
+    // Packing saturates to 255, like std::min
+    auto i = std::size_t{0};
+    for(; i+16 <= count; i += 16)
+    {
+        auto const low = _mm_packs_epi32(convert(i), convert(i+4));
+        auto const high = _mm_packs_epi32(convert(i+8), convert(i+12));
+        _mm_storeu_si128(
+            static_cast<__m128i *>(static_cast<void *>(out+i)),
+            _mm_packus_epi16(low, high));
+    }
+
+    coverage_to_8bit_scalar(coverage+i, out+i, count-i);
+}
+
+} /* namespace detail */
+
+} /* namespace wttf */
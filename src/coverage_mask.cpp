@@ -0,0 +1,122 @@
+#include <wttf/coverage_mask.hpp>
+#include <wttf/assert.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace wttf
+{
+
+namespace
+{
+
+// Shorter runs are stored as literal bytes. A segment takes six bytes, so
+// interrupting a literal segment for a short solid run does not pay off.
+constexpr std::size_t min_solid_length = 8;
+
+// Gaps of zero coverage up to this length, between literal runs, are stored
+// as literal zeros rather than by starting a new segment.
+constexpr std::size_t max_literal_gap = sizeof(coverage_mask::segment);
+
+} /* namespace */
+
+coverage_mask::coverage_mask(
+    std::size_t x, std::size_t y, std::size_t width, std::size_t height):
+    m_x{x}, m_y{y},
+    m_width{width}, m_height{height}
+{
+    WTTF_ASSERT(width <= 0xFFFF);
+    m_rows.reserve(height+1);
+}
+
+coverage_mask::row_view coverage_mask::row(std::size_t y) const
+{
+    WTTF_ASSERT(y < m_height);
+
+    auto const & first = m_rows[y];
+    auto const & last = m_rows[y+1];
+    return {
+        m_segments.data() + first.segment,
+        m_segments.data() + last.segment,
+        m_literals.data() + first.literal};
+}
+
+std::size_t coverage_mask::size_in_bytes() const
+{
+    return
+        m_segments.size() * sizeof(segment) +
+        m_literals.size() +
+        m_rows.size() * sizeof(row_start);
+}
+
+void coverage_mask::add_span(
+    std::size_t y, std::size_t x, std::size_t count, std::uint8_t coverage)
+{
+    WTTF_ASSERT(y < m_height && x + count <= m_width);
+
+    while(m_rows.size() <= y)
+    {
+        m_rows.push_back({
+            static_cast<std::uint32_t>(m_segments.size()),
+            static_cast<std::uint32_t>(m_literals.size())});
+    }
+
+    if(coverage == 0 || count == 0)
+        return;
+
+    auto * const last =
+        m_segments.size() > m_rows[y].segment ? &m_segments.back() : nullptr;
+    auto const last_end = last ? std::size_t{last->x} + last->length : 0;
+
+    if(last && last->literal && count < min_solid_length &&
+        x > last_end && x - last_end <= max_literal_gap)
+    {
+        m_literals.insert(std::end(m_literals), x - last_end, 0);
+        last->length = static_cast<std::uint16_t>(x - last->x);
+    }
+
+    auto const adjacent = last && last->x + last->length == x;
+
+    if(adjacent && !last->literal && last->coverage == coverage)
+    {
+        last->length = static_cast<std::uint16_t>(last->length + count);
+    }
+    else if(count >= min_solid_length)
+    {
+        m_segments.push_back({
+            static_cast<std::uint16_t>(x), static_cast<std::uint16_t>(count),
+            coverage, false});
+    }
+    else
+    {
+        if(adjacent && last->literal)
+        {
+            last->length = static_cast<std::uint16_t>(last->length + count);
+        }
+        else
+        {
+            m_segments.push_back({
+                static_cast<std::uint16_t>(x),
+                static_cast<std::uint16_t>(count),
+                0, true});
+        }
+
+        m_literals.insert(std::end(m_literals), count, coverage);
+    }
+}
+
+void coverage_mask::finish()
+{
+    while(m_rows.size() <= m_height)
+    {
+        m_rows.push_back({
+            static_cast<std::uint32_t>(m_segments.size()),
+            static_cast<std::uint32_t>(m_literals.size())});
+    }
+
+    m_segments.shrink_to_fit();
+    m_literals.shrink_to_fit();
+}
+
+} /* namespace wttf */
@@ -0,0 +1,98 @@
+#ifndef WTTF_FIXED_VECTOR_HPP
+#define WTTF_FIXED_VECTOR_HPP
+
+#include <wttf/assert.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+/*
+ * Vector with its elements stored inside the object, for small buffers that
+ * can live on the stack. Has the parts of the std::vector interface the
+ * rasterizer needs. Elements past capacity are dropped, and overflow() tells
+ * if that has happened.
+ */
+template <typename T, std::size_t Capacity>
+class fixed_vector
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T *;
+    using const_iterator = T const *;
+
+    // Not defaulted, so that value-initialization does not clear the storage
+    fixed_vector() {}
+
+    explicit fixed_vector(size_type count):
+        m_size{count}
+    {
+        WTTF_ASSERT(count <= Capacity);
+        std::fill_n(m_data.data(), count, T{});
+    }
+
+    [[nodiscard]] static constexpr size_type capacity() { return Capacity; }
+    [[nodiscard]] size_type size() const { return m_size; }
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+    [[nodiscard]] bool overflow() const { return m_overflow; }
+
+    T * data() { return m_data.data(); }
+    T const * data() const { return m_data.data(); }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + m_size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + m_size; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    T & operator[](size_type i) { return m_data[i]; }
+    T const & operator[](size_type i) const { return m_data[i]; }
+    T & back() { return m_data[m_size-1]; }
+    T const & back() const { return m_data[m_size-1]; }
+
+    void reserve(size_type) {}
+    void clear() { m_size = 0; }
+
+    void push_back(T const & value)
+    {
+        if(m_size == Capacity)
+        {
+            m_overflow = true;
+            return;
+        }
+
+        m_data[m_size++] = value;
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        auto * const pos = begin() + (first - cbegin());
+        auto * const new_end = std::copy(
+            begin() + (last - cbegin()), end(), pos);
+        m_size = static_cast<size_type>(new_end - begin());
+        return pos;
+    }
+
+    private:
+    std::array<T, Capacity> m_data;
+    size_type m_size{0};
+    bool m_overflow{false};
+};
+
+} /* namespace detail */
+
+} /* namespace wttf */
+
+#endif /* WTTF_FIXED_VECTOR_HPP */
@@ -2,11 +2,13 @@
 #define WTTF_FONT_DATA_HPP
 
 #include <wttf/assert.hpp>
+#include "font_file.hpp"
 
 #include <array>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <vector>
 #include <utility>
 
@@ -94,7 +96,7 @@ namespace detail
 {
 
 template <typename T>
-T extract_from_data(std::vector<std::byte> const & data, std::size_t offset)
+T extract_from_data(std::byte const * data, std::size_t offset)
 {
     using U = std::make_unsigned_t<T>;
     static constexpr auto size = sizeof(T);
@@ -111,7 +113,7 @@ T extract_from_data(std::vector<std::byte> const & data, std::size_t offset)
 
 template<>
 inline tag_t extract_from_data<tag_t>(
-    std::vector<std::byte> const & data, std::size_t offset)
+    std::byte const * data, std::size_t offset)
 {
     return tag_t{
         extract_from_data<std::uint8_t>(data, offset+0),
@@ -122,7 +124,7 @@ inline tag_t extract_from_data<tag_t>(
 
 template<>
 inline table_entry extract_from_data<table_entry>(
-    std::vector<std::byte> const & data, std::size_t offset)
+    std::byte const * data, std::size_t offset)
 {
     return table_entry{
         extract_from_data<tag_t>(data, offset+0),
@@ -133,7 +135,7 @@ inline table_entry extract_from_data<table_entry>(
 
 template<>
 inline encoding_record extract_from_data<encoding_record>(
-    std::vector<std::byte> const & data, std::size_t offset)
+    std::byte const * data, std::size_t offset)
 {
     return encoding_record{
         extract_from_data<platform_id>(data, offset+0),
@@ -143,7 +145,7 @@ inline encoding_record extract_from_data<encoding_record>(
 
 template<>
 inline glyph_header extract_from_data<glyph_header>(
-    std::vector<std::byte> const & data, std::size_t offset)
+    std::byte const * data, std::size_t offset)
 {
     return glyph_header{
         extract_from_data<std::int16_t>(data, offset+0),
@@ -188,11 +190,21 @@ struct font_data
     };
 
     font_data() = delete;
-    font_data(font_data const &) = default;
+    font_data(font_data const &) = delete;
     font_data(font_data &&) = delete;
 
     font_data(std::vector<std::byte> && data):
-        bytes{std::forward<std::vector<std::byte>>(data)}
+        bytes{std::forward<std::vector<std::byte>>(data)},
+        m_begin{bytes.data()},
+        m_size{bytes.size()}
+    {}
+
+    // Data read from the file on demand. bytes is left empty.
+    explicit font_data(std::shared_ptr<detail::font_file const> f):
+        bytes{},
+        file{std::move(f)},
+        m_begin{file->data()},
+        m_size{file->size()}
     {}
 
     ~font_data() = default;
@@ -208,10 +220,30 @@ struct font_data
     template <typename T>
     T get(std::size_t offset) const
     {
-        return detail::extract_from_data<T>(bytes, offset);
+        return detail::extract_from_data<T>(m_begin, offset);
     }
 
+    /*
+     * Reads size bytes at offset from the file, unless read already. Does
+     * nothing for data in memory. Everything is loaded when checked, before
+     * reading it, so that get only ever reads loaded data. Returns false if
+     * the file could not be read, in which case the data must be treated
+     * as invalid.
+     */
+    [[nodiscard]] bool load(std::size_t offset, std::size_t size) const
+    {
+        return !file || file->load(offset, size);
+    }
+
+    [[nodiscard]] std::byte const * begin() const { return m_begin; }
+    [[nodiscard]] std::size_t size() const { return m_size; }
+
     std::vector<std::byte> const bytes;
+    std::shared_ptr<detail::font_file const> const file{};
+
+    private:
+    std::byte const * const m_begin;
+    std::size_t const m_size;
 };
 
 } /* namespace wttf */
@@ -0,0 +1,232 @@
+#include "font_file.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#if defined(_WIN32)
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wttf
+{
+
+namespace detail
+{
+
+#if defined(_WIN32)
+
+namespace
+{
+
+std::size_t system_page_size()
+{
+    auto info = SYSTEM_INFO{};
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+} /* namespace */
+
+font_file::font_file(std::filesystem::path const & path):
+    m_page_size{system_page_size()},
+    m_file{_wfopen(path.c_str(), L"rb")}
+{
+    if(m_file == nullptr || std::fseek(m_file, 0, SEEK_END) != 0)
+        return;
+
+    auto const size = std::ftell(m_file);
+    if(size <= 0)
+        return;
+
+    // Reserved only, memory is committed page by page
+    m_buffer = static_cast<std::byte *>(VirtualAlloc(
+        nullptr, static_cast<std::size_t>(size), MEM_RESERVE,
+        PAGE_NOACCESS));
+    if(m_buffer == nullptr)
+        return;
+
+    m_size = static_cast<std::size_t>(size);
+    m_pages = std::make_unique<std::atomic<page_state>[]>(
+        (m_size + m_page_size - 1) / m_page_size);
+}
+
+font_file::~font_file()
+{
+    if(m_buffer != nullptr)
+        VirtualFree(m_buffer, 0, MEM_RELEASE);
+
+    if(m_file != nullptr)
+        std::fclose(m_file);
+}
+
+bool font_file::commit(std::size_t offset, std::size_t size) const
+{
+    return VirtualAlloc(
+        m_buffer + offset, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+#else
+
+namespace
+{
+
+std::size_t system_page_size()
+{
+    auto const size = ::sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : std::size_t{4096};
+}
+
+} /* namespace */
+
+font_file::font_file(std::filesystem::path const & path):
+    m_page_size{system_page_size()},
+    m_fd{::open(path.c_str(), O_RDONLY | O_CLOEXEC)}
+{
+    struct stat st{};
+    if(m_fd < 0 || ::fstat(m_fd, &st) != 0 || st.st_size <= 0)
+        return;
+
+    // Inaccessible pages are reserved only, and not counted as committed
+    // memory even when the system does not overcommit
+    auto const size = static_cast<std::size_t>(st.st_size);
+    auto const p = ::mmap(
+        nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+        -1, 0);
+    if(p == MAP_FAILED)
+        return;
+
+    m_size = size;
+    m_buffer = static_cast<std::byte *>(p);
+    m_pages = std::make_unique<std::atomic<page_state>[]>(
+        (m_size + m_page_size - 1) / m_page_size);
+}
+
+font_file::~font_file()
+{
+    if(m_buffer != nullptr)
+        ::munmap(m_buffer, m_size);
+
+    if(m_fd >= 0)
+        ::close(m_fd);
+}
+
+bool font_file::commit(std::size_t offset, std::size_t size) const
+{
+    return ::mprotect(m_buffer + offset, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+#endif
+
+bool font_file::load(std::size_t offset, std::size_t size) const
+{
+    if(!m_buffer || offset >= m_size || size == 0)
+        return true;
+
+    auto const first = offset / m_page_size;
+    auto const last = (std::min(offset + size, m_size) - 1) / m_page_size;
+
+    // Claim the missing pages, and read each run of consecutive claimed
+    // pages at once. Pages claimed by other threads end a run.
+    auto run = first;
+    for(auto index = first; index <= last; ++index)
+    {
+        auto expected = unloaded;
+        if(!m_pages[index].compare_exchange_strong(
+            expected, loading, std::memory_order_acquire))
+        {
+            read_pages(run, index - run);
+            run = index + 1;
+        }
+    }
+    read_pages(run, last + 1 - run);
+
+    // Pages claimed by other threads are read by them
+    auto ok = true;
+    for(auto index = first; index <= last; ++index)
+    {
+        auto state = m_pages[index].load(std::memory_order_acquire);
+        while(state == loading)
+        {
+            std::this_thread::yield();
+            state = m_pages[index].load(std::memory_order_acquire);
+        }
+
+        ok = ok && state == loaded;
+    }
+
+    return ok;
+}
+
+void font_file::read_pages(std::size_t first, std::size_t count) const
+{
+    if(count == 0)
+        return;
+
+    // Committed in whole pages, which the reservation is rounded up to
+    auto const offset = first * m_page_size;
+    auto const size = std::min(count * m_page_size, m_size - offset);
+    auto const done = commit(offset, count * m_page_size) ?
+        read(offset, size) :
+        std::size_t{0};
+
+    // Pages which were not read completely are failed, and zeros if memory
+    // for them was committed
+    for(auto index = first; index != first + count; ++index)
+    {
+        auto const page_end = std::min((index + 1) * m_page_size, m_size);
+        m_pages[index].store(
+            page_end <= offset + done ? loaded : failed,
+            std::memory_order_release);
+    }
+}
+
+#if defined(_WIN32)
+
+std::size_t font_file::read(std::size_t offset, std::size_t size) const
+{
+    auto const lock = std::lock_guard{m_mutex};
+    if(std::fseek(m_file, static_cast<long>(offset), SEEK_SET) != 0)
+        return 0;
+
+    return std::fread(m_buffer + offset, 1, size, m_file);
+}
+
+#else
+
+std::size_t font_file::read(std::size_t offset, std::size_t size) const
+{
+    auto done = std::size_t{0};
+    while(done != size)
+    {
+        auto const n = ::pread(
+            m_fd, m_buffer + offset + done, size - done,
+            static_cast<off_t>(offset + done));
+        if(n < 0 && errno == EINTR)
+            continue;
+
+        if(n <= 0)
+            break;
+
+        done += static_cast<std::size_t>(n);
+    }
+
+    return done;
+}
+
+#endif
+
+} /* namespace detail */
+
+} /* namespace wttf */
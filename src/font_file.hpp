@@ -0,0 +1,96 @@
+#ifndef WTTF_FONT_FILE_HPP
+#define WTTF_FONT_FILE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+/*
+ * Font file, which is read in pages on demand. Address space as large as
+ * the file is reserved up front, and memory for each page is committed only
+ * when the page is read, so memory use is bounded by the pages read even on
+ * systems, which do not overcommit. Pages are read once, and never again,
+ * so data which has been checked does not change even if the file does.
+ *
+ * Threads claim the pages they read with atomics, and read consecutive
+ * missing pages with one call. With pread, threads reading different pages
+ * don't wait for each other.
+ */
+class font_file
+{
+    public:
+    // If the file can't be opened, it is left closed
+    explicit font_file(std::filesystem::path const & path);
+
+    font_file(font_file const &) = delete;
+    font_file(font_file &&) = delete;
+
+    ~font_file();
+
+    font_file & operator=(font_file const &) = delete;
+    font_file & operator=(font_file &&) = delete;
+
+    explicit operator bool() const { return m_buffer != nullptr; }
+
+    [[nodiscard]] std::size_t size() const { return m_size; }
+
+    // Contents of the file. Pages, which have not been loaded, may not be
+    // accessible, and must not be read.
+    [[nodiscard]] std::byte const * data() const { return m_buffer; }
+
+    /*
+     * Reads the pages with size bytes at offset, unless read already.
+     * Returns false if any of them could not be read completely, for
+     * example because the file was truncated. Such pages are not tried
+     * again, and stay failed.
+     */
+    [[nodiscard]] bool load(std::size_t offset, std::size_t size) const;
+
+    private:
+    enum page_state: std::uint8_t
+    {
+        unloaded,
+        loading, // Claimed by a thread reading it
+        loaded,
+        failed
+    };
+
+    // Commits memory for count pages starting from first, which the calling
+    // thread has claimed, reads them and sets their states
+    void read_pages(std::size_t first, std::size_t count) const;
+
+    // Reads size bytes at offset to the buffer, returns the bytes read
+    std::size_t read(std::size_t offset, std::size_t size) const;
+
+    // Makes size bytes of the reservation at offset readable and writable
+    bool commit(std::size_t offset, std::size_t size) const;
+
+    std::size_t m_size{0};
+    std::size_t m_page_size{0}; // Of the system, unit of reading too
+    std::byte * m_buffer{nullptr};
+    std::unique_ptr<std::atomic<page_state>[]> m_pages{};
+
+#if defined(_WIN32)
+    // fseek and fread share the file position, so they are done under lock
+    mutable std::mutex m_mutex{};
+    std::FILE * m_file{nullptr};
+#else
+    int m_fd{-1};
+#endif
+}; /* class font_file */
+
+} /* namespace detail */
+
+} /* namespace wttf */
+
+#endif /* WTTF_FONT_FILE_HPP */
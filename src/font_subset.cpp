@@ -0,0 +1,467 @@
+#include <wttf/typeface.hpp>
+#include "font_data.hpp"
+#include "font_validation.hpp"
+#include "typeface_p.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace wttf
+{
+
+namespace
+{
+
+using table_data = std::vector<std::byte>;
+
+void put16(table_data & t, std::uint32_t value)
+{
+    t.push_back(static_cast<std::byte>(value >> 8));
+    t.push_back(static_cast<std::byte>(value));
+}
+
+void put32(table_data & t, std::uint32_t value)
+{
+    put16(t, value >> 16);
+    put16(t, value);
+}
+
+std::uint16_t get16(table_data const & t, std::size_t offset)
+{
+    return static_cast<std::uint16_t>(
+        std::to_integer<unsigned>(t[offset]) << 8 |
+        std::to_integer<unsigned>(t[offset+1]));
+}
+
+void set16(table_data & t, std::size_t offset, std::uint32_t value)
+{
+    t[offset] = static_cast<std::byte>(value >> 8);
+    t[offset+1] = static_cast<std::byte>(value);
+}
+
+void set32(table_data & t, std::size_t offset, std::uint32_t value)
+{
+    set16(t, offset, value >> 16);
+    set16(t, offset+2, value);
+}
+
+void pad(table_data & t)
+{
+    t.resize((t.size() + 3) & ~std::size_t{3});
+}
+
+// Sum of big-endian 32-bit words, as in the table directory
+std::uint32_t checksum(
+    table_data const & t, std::size_t offset, std::size_t size)
+{
+    auto sum = std::uint32_t{0};
+    for(auto i = std::size_t{0}; i < size; i += 4)
+    {
+        auto word = std::uint32_t{0};
+        for(auto j = std::size_t{0}; j != 4; ++j)
+        {
+            word <<= 8;
+            if(i + j < size)
+                word |= std::to_integer<std::uint32_t>(t[offset + i + j]);
+        }
+        sum += word;
+    }
+
+    return sum;
+}
+
+// searchRange, entrySelector and rangeShift fields for a binary search of
+// count items of size bytes
+void put_search_fields(table_data & t, std::size_t count, std::size_t size)
+{
+    auto entry_selector = 0u;
+    while((2u << entry_selector) <= count)
+    {
+        ++entry_selector;
+    }
+
+    auto const search_range = (std::size_t{1} << entry_selector) * size;
+    put16(t, static_cast<std::uint32_t>(search_range));
+    put16(t, entry_selector);
+    put16(t, static_cast<std::uint32_t>(count * size - search_range));
+}
+
+// Replaces glyph indices of the components of a composite glyph, copied to
+// offset of glyf, with their indices in the subset
+void renumber_components(
+    table_data & glyf, std::size_t offset,
+    std::vector<std::uint16_t> const & new_index)
+{
+    offset += glyph_header::byte_size;
+    auto flags =
+        static_cast<std::uint16_t>(composite_glyph_flags::more_components);
+
+    while(flags & composite_glyph_flags::more_components)
+    {
+        flags = get16(glyf, offset);
+        set16(glyf, offset+2, new_index[get16(glyf, offset+2)]);
+
+        offset += 4;
+        offset += (flags & composite_glyph_flags::arg_1_and_arg_2_are_words) ?
+            4 : 2;
+
+        if(flags & composite_glyph_flags::we_have_a_scale)
+            offset += 2;
+        else if(flags & composite_glyph_flags::we_have_x_and_y_scale)
+            offset += 4;
+        else if(flags & composite_glyph_flags::we_have_a_two_by_two)
+            offset += 8;
+    }
+}
+
+/*
+ * Format 4 cmap with one segment for each run of consecutive codepoints.
+ * Runs of consecutive glyphs are mapped with idDelta, others through the
+ * glyph array. Mapping is sorted by codepoint, without 0xFFFF.
+ */
+table_data make_cmap(
+    std::vector<std::pair<std::uint16_t, std::uint16_t>> const & mapping)
+{
+    struct segment
+    {
+        std::size_t first;
+        std::size_t last;
+        bool consecutive;
+    };
+
+    auto segments = std::vector<segment>{};
+    for(auto i = std::size_t{0}; i != mapping.size(); ++i)
+    {
+        auto const & [c, g] = mapping[i];
+        if(!segments.empty() && mapping[i-1].first + 1u == c)
+        {
+            auto & s = segments.back();
+            s.consecutive = s.consecutive && mapping[i-1].second + 1u == g;
+            s.last = i;
+        }
+        else
+        {
+            segments.push_back({i, i, true});
+        }
+    }
+
+    // Last segment must end at 0xFFFF. It maps to glyph 0.
+    auto const seg_count = segments.size() + 1;
+
+    auto t = table_data{};
+    put16(t, 0); // version
+    put16(t, 1); // numTables
+    put16(t, static_cast<std::uint16_t>(platform_id::windows));
+    put16(t, windows_unicode_bmp_encoding_id);
+    put32(t, 12);
+
+    auto const sub = t.size();
+    put16(t, 4); // format
+    put16(t, 0); // length, set below
+    put16(t, 0); // language
+    put16(t, static_cast<std::uint32_t>(seg_count * 2));
+    put_search_fields(t, seg_count, 2);
+
+    for(auto const & s: segments)
+    {
+        put16(t, mapping[s.last].first);
+    }
+    put16(t, 0xFFFF);
+    put16(t, 0); // reservedPad
+
+    for(auto const & s: segments)
+    {
+        put16(t, mapping[s.first].first);
+    }
+    put16(t, 0xFFFF);
+
+    for(auto const & s: segments)
+    {
+        auto const & [c, g] = mapping[s.first];
+        auto const delta = static_cast<std::uint32_t>(g - c) & 0xFFFFu;
+        put16(t, s.consecutive ? delta : 0u);
+    }
+    put16(t, 1);
+
+    // Range offsets are relative to their own position
+    auto glyph_array_size = std::size_t{0};
+    for(auto i = std::size_t{0}; i != segments.size(); ++i)
+    {
+        auto const & s = segments[i];
+        if(s.consecutive)
+        {
+            put16(t, 0);
+            continue;
+        }
+
+        put16(
+            t,
+            static_cast<std::uint32_t>(
+                (seg_count - i) * 2 + glyph_array_size * 2));
+        glyph_array_size += s.last - s.first + 1;
+    }
+    put16(t, 0);
+
+    for(auto const & s: segments)
+    {
+        if(s.consecutive)
+            continue;
+
+        for(auto i = s.first; i <= s.last; ++i)
+        {
+            put16(t, mapping[i].second);
+        }
+    }
+
+    // Lookups do not use the length, which overflows only for huge subsets
+    set16(
+        t, sub + 2,
+        static_cast<std::uint32_t>(std::min<std::size_t>(
+            t.size() - sub, 0xFFFF)));
+
+    return t;
+}
+
+// Format 0 kern table with pairs sorted by glyph1, and then by glyph2
+table_data make_kern(
+    std::vector<std::tuple<std::uint16_t, std::uint16_t, std::int16_t>> const &
+        pairs)
+{
+    auto t = table_data{};
+    put16(t, 0); // version
+    put16(t, 1); // nTables
+
+    put16(t, 0); // subtable version
+    put16(
+        t,
+        static_cast<std::uint32_t>(
+            std::min<std::size_t>(14 + pairs.size() * 6, 0xFFFF)));
+    put16(t, 0x0001); // horizontal, format 0
+    put16(t, static_cast<std::uint32_t>(pairs.size()));
+    put_search_fields(t, pairs.size(), 6);
+
+    for(auto const & [left, right, value]: pairs)
+    {
+        put16(t, left);
+        put16(t, right);
+        put16(t, static_cast<std::uint16_t>(value));
+    }
+
+    return t;
+}
+
+} /* namespace */
+
+font_subset typeface::implementation::subset(
+    std::vector<std::uint16_t> const & glyphs,
+    std::vector<unsigned int> const * codepoints) const
+{
+    load_glyphs();
+    if(m_glyphs_error != font_error::none)
+        return {};
+
+    // Components are added as they are found. A glyph is visited once, so
+    // cyclic references end too.
+    auto keep = std::vector<bool>(m_num_glyphs);
+    auto pending = std::vector<std::uint16_t>{0};
+    pending.insert(pending.end(), glyphs.begin(), glyphs.end());
+
+    while(!pending.empty())
+    {
+        auto const g = pending.back();
+        pending.pop_back();
+        if(g >= m_num_glyphs || keep[g])
+            continue;
+
+        keep[g] = true;
+        auto const offset = glyph_offset(g);
+        if(offset && get<std::int16_t>(offset) < 0)
+        {
+            for_each_component(
+                offset,
+                [&pending](std::uint16_t index, transform const &)
+                {
+                    pending.push_back(index);
+                });
+        }
+    }
+
+    auto result = font_subset{};
+    auto new_index = std::vector<std::uint16_t>(m_num_glyphs);
+    for(auto g = 0u; g != m_num_glyphs; ++g)
+    {
+        if(!keep[g])
+            continue;
+
+        new_index[g] = static_cast<std::uint16_t>(result.glyphs.size());
+        result.glyphs.push_back(static_cast<std::uint16_t>(g));
+    }
+
+    auto const num_glyphs = result.glyphs.size();
+    auto const bytes = m_data->begin();
+
+    auto glyf = table_data{};
+    auto hmtx = table_data{};
+    auto locations = std::vector<std::size_t>{};
+    for(auto const g: result.glyphs)
+    {
+        locations.push_back(glyf.size());
+
+        auto const m = metrics(g);
+        put16(hmtx, static_cast<std::uint16_t>(m.advance));
+        put16(
+            hmtx,
+            static_cast<std::uint16_t>(
+                static_cast<std::int16_t>(m.left_side_bearing)));
+
+        auto const offset = glyph_offset(g);
+        auto const size = glyph_size(g);
+        if(size == 0)
+            continue;
+
+        auto const start = glyf.size();
+        auto const first = bytes + offset;
+        glyf.insert(glyf.end(), first, first + size);
+        if(get<std::int16_t>(offset) < 0)
+        {
+            renumber_components(glyf, start, new_index);
+        }
+        pad(glyf);
+    }
+    locations.push_back(glyf.size());
+
+    // Empty tables count as missing, even if all glyphs are empty
+    if(glyf.empty())
+    {
+        glyf.resize(4);
+    }
+
+    // Glyphs are padded to four bytes, so the short format works while
+    // offsets fit into 16 bits after halving
+    auto const short_loca = glyf.size() <= 0x1FFFE;
+    auto loca = table_data{};
+    for(auto const l: locations)
+    {
+        if(short_loca)
+            put16(loca, static_cast<std::uint32_t>(l / 2));
+        else
+            put32(loca, static_cast<std::uint32_t>(l));
+    }
+
+    auto mapping = std::vector<std::pair<std::uint16_t, std::uint16_t>>{};
+    auto const map_codepoint = [&](unsigned int c)
+    {
+        if(c >= 0xFFFF)
+            return;
+
+        auto const g = glyph_index(c);
+        if(g != 0 && g < m_num_glyphs && keep[g])
+        {
+            mapping.emplace_back(
+                static_cast<std::uint16_t>(c), new_index[g]);
+        }
+    };
+
+    if(codepoints)
+    {
+        std::for_each(codepoints->begin(), codepoints->end(), map_codepoint);
+        std::sort(mapping.begin(), mapping.end());
+        mapping.erase(
+            std::unique(mapping.begin(), mapping.end()), mapping.end());
+    }
+    else
+    {
+        for(auto c = 0u; c != 0xFFFF; ++c)
+        {
+            map_codepoint(c);
+        }
+    }
+
+    // Renumbering keeps the order of the pairs
+    auto kerning_pairs =
+        std::vector<std::tuple<std::uint16_t, std::uint16_t, std::int16_t>>{};
+    for_each_kerning_pair(
+        [&](std::uint16_t glyph1, std::uint16_t glyph2, float value)
+        {
+            if(glyph1 < m_num_glyphs && glyph2 < m_num_glyphs &&
+                keep[glyph1] && keep[glyph2])
+            {
+                kerning_pairs.emplace_back(
+                    new_index[glyph1], new_index[glyph2],
+                    static_cast<std::int16_t>(value));
+            }
+        });
+
+    auto const copy_table = [this, &bytes](char const * tag)
+    {
+        auto const table = detail::find_table(*m_data, m_data_offset, tag);
+        return table_data(
+            bytes + table.offset, bytes + table.offset + table.length);
+    };
+
+    auto head = copy_table("head");
+    set32(head, 8, 0); // checkSumAdjustment, set below
+    set16(head, 50, short_loca ? 0 : 1);
+
+    auto hhea = copy_table("hhea");
+    set16(hhea, 34, static_cast<std::uint32_t>(num_glyphs));
+
+    auto maxp = copy_table("maxp");
+    set16(maxp, 4, static_cast<std::uint32_t>(num_glyphs));
+
+    // In the order of their tags
+    auto tables = std::vector<std::pair<char const *, table_data>>{};
+    tables.emplace_back("cmap", make_cmap(mapping));
+    tables.emplace_back("glyf", std::move(glyf));
+    tables.emplace_back("head", std::move(head));
+    tables.emplace_back("hhea", std::move(hhea));
+    tables.emplace_back("hmtx", std::move(hmtx));
+    if(!kerning_pairs.empty())
+    {
+        tables.emplace_back("kern", make_kern(kerning_pairs));
+    }
+    tables.emplace_back("loca", std::move(loca));
+    tables.emplace_back("maxp", std::move(maxp));
+
+    auto & data = result.data;
+    put32(data, 0x00010000); // sfntVersion
+    put16(data, static_cast<std::uint32_t>(tables.size()));
+    put_search_fields(data, tables.size(), table_entry::byte_size);
+
+    auto offset = data.size() + tables.size() * table_entry::byte_size;
+    auto head_offset = std::size_t{0};
+    for(auto const & [tag, table]: tables)
+    {
+        for(auto i = 0u; i != 4; ++i)
+        {
+            data.push_back(static_cast<std::byte>(tag[i]));
+        }
+        put32(data, checksum(table, 0, table.size()));
+        put32(data, static_cast<std::uint32_t>(offset));
+        put32(data, static_cast<std::uint32_t>(table.size()));
+
+        if(tag == std::string_view{"head"})
+            head_offset = offset;
+
+        offset += (table.size() + 3) & ~std::size_t{3};
+    }
+
+    for(auto const & [tag, table]: tables)
+    {
+        data.insert(data.end(), table.begin(), table.end());
+        pad(data);
+    }
+
+    set32(
+        data, head_offset + 8,
+        0xB1B0AFBA - checksum(data, 0, data.size()));
+
+    return result;
+}
+
+} /* namespace wttf */
@@ -0,0 +1,430 @@
+#include "font_validation.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+namespace
+{
+
+bool valid_table_directory(font_data const & data, std::size_t font_offset)
+{
+    auto const file = table{0, data.size()};
+    if(!file.contains(font_offset, 12))
+        return false;
+
+    if(!data.load(font_offset, 12))
+        return false;
+
+    auto const num_tables = data.get<std::uint16_t>(font_offset+4);
+    auto const directory = font_offset + 12;
+    if(!file.contains(directory, num_tables*table_entry::byte_size))
+        return false;
+
+    if(!data.load(directory, num_tables*table_entry::byte_size))
+        return false;
+
+    for(auto i = 0u; i != num_tables; ++i)
+    {
+        auto const entry = data.get<table_entry>(
+            directory + i*table_entry::byte_size);
+        if(!file.contains(entry.offset, entry.length))
+            return false;
+    }
+
+    return true;
+}
+
+bool valid_format0_cmap(
+    font_data const & data, table const & cmap, std::size_t sub)
+{
+    if(!cmap.contains(sub, 6))
+        return false;
+
+    auto const length = data.get<std::uint16_t>(sub+2);
+    return length >= 6 && cmap.contains(sub, length);
+}
+
+bool valid_format4_cmap(
+    font_data const & data, table const & cmap, std::size_t sub)
+{
+    if(!cmap.contains(sub, 14))
+        return false;
+
+    auto const seg_count_x2 = data.get<std::uint16_t>(sub+6);
+    auto const seg_count = seg_count_x2 / 2u;
+    if(seg_count == 0 || seg_count_x2 % 2 != 0)
+        return false;
+
+    // End codes, padding, start codes, deltas and range offsets
+    if(!cmap.contains(sub + 14, seg_count * 8u + 2u))
+        return false;
+
+    auto const end_codes = sub + 14;
+    auto const start_codes = end_codes + seg_count_x2 + 2;
+    auto const range_offsets = start_codes + seg_count_x2 * 2u;
+
+    for(auto i = 0u; i != seg_count; ++i)
+    {
+        auto const end = data.get<std::uint16_t>(end_codes + i*2);
+        auto const start = data.get<std::uint16_t>(start_codes + i*2);
+        auto const range_offset =
+            data.get<std::uint16_t>(range_offsets + i*2);
+
+        if(start > end)
+            return false;
+
+        if(i > 0 && end <= data.get<std::uint16_t>(end_codes + i*2 - 2))
+            return false;
+
+        if(range_offset != 0 &&
+            !cmap.contains(
+                range_offsets + i*2 + range_offset,
+                (end - start + 1u) * 2u))
+            return false;
+    }
+
+    // Search relies on the last segment ending at 0xFFFF
+    return
+        data.get<std::uint16_t>(end_codes + seg_count_x2 - 2) == 0xFFFF;
+}
+
+bool valid_format6_cmap(
+    font_data const & data, table const & cmap, std::size_t sub)
+{
+    if(!cmap.contains(sub, 10))
+        return false;
+
+    auto const entry_count = data.get<std::uint16_t>(sub+8);
+    return cmap.contains(sub + 10, entry_count * 2u);
+}
+
+bool valid_simple_glyph(font_data const & data, table const & glyph)
+{
+    auto const number_of_contours =
+        static_cast<std::uint16_t>(data.get<std::int16_t>(glyph.offset));
+    auto const end_pts = glyph.offset + glyph_header::byte_size;
+    if(!glyph.contains(end_pts, number_of_contours * 2u + 2u))
+        return false;
+
+    // Contour sizes are computed from the end points
+    for(auto i = 1u; i < number_of_contours; ++i)
+    {
+        if(data.get<std::uint16_t>(end_pts + i*2) <=
+            data.get<std::uint16_t>(end_pts + i*2 - 2))
+            return false;
+    }
+
+    auto const num_points =
+        std::size_t{1} +
+        data.get<std::uint16_t>(end_pts + (number_of_contours-1u) * 2u);
+    auto const instruction_length =
+        data.get<std::uint16_t>(end_pts + number_of_contours * 2u);
+
+    // Same walk over the flags as when decoding the glyph
+    auto offset =
+        end_pts + number_of_contours * 2u + 2u + instruction_length;
+    auto coords_size = std::size_t{0};
+
+    for(auto i = std::size_t{0}; i < num_points;)
+    {
+        if(!glyph.contains(offset, 1))
+            return false;
+
+        auto const f = data.get<std::uint8_t>(offset++);
+        auto count = std::size_t{1};
+        if(f & simple_glyph_flags::repeat_flag)
+        {
+            if(!glyph.contains(offset, 1))
+                return false;
+
+            count += data.get<std::uint8_t>(offset++);
+        }
+        count = std::min(count, num_points - i);
+
+        if(f & simple_glyph_flags::x_short_vector)
+            coords_size += count;
+        else if(!(f & simple_glyph_flags::x_is_same_or_positive_x_short_vector))
+            coords_size += count * 2;
+
+        if(f & simple_glyph_flags::y_short_vector)
+            coords_size += count;
+        else if(!(f & simple_glyph_flags::y_is_same_or_positive_y_short_vector))
+            coords_size += count * 2;
+
+        i += count;
+    }
+
+    return glyph.contains(offset, coords_size);
+}
+
+bool valid_composite_glyph(
+    font_data const & data, table const & glyph, std::size_t num_glyphs)
+{
+    auto offset = glyph.offset + glyph_header::byte_size;
+    auto flags =
+        static_cast<std::uint16_t>(composite_glyph_flags::more_components);
+
+    while(flags & composite_glyph_flags::more_components)
+    {
+        if(!glyph.contains(offset, 4))
+            return false;
+
+        flags = data.get<std::uint16_t>(offset);
+        if(data.get<std::uint16_t>(offset+2) >= num_glyphs)
+            return false;
+
+        auto size = std::size_t{4};
+        size += (flags & composite_glyph_flags::arg_1_and_arg_2_are_words) ?
+            4 : 2;
+
+        if(flags & composite_glyph_flags::we_have_a_scale)
+            size += 2;
+        else if(flags & composite_glyph_flags::we_have_x_and_y_scale)
+            size += 4;
+        else if(flags & composite_glyph_flags::we_have_a_two_by_two)
+            size += 8;
+
+        if(!glyph.contains(offset, size))
+            return false;
+
+        offset += size;
+    }
+
+    return true;
+}
+
+} /* namespace */
+
+table find_table(
+    font_data const & data, std::size_t font_offset, char const * tag)
+{
+    auto const t = tag_from_c_string(tag);
+    auto const num_tables = data.get<std::uint16_t>(font_offset+4);
+
+    for(auto i = 0u; i != num_tables; ++i)
+    {
+        auto const entry = data.get<table_entry>(
+            font_offset + 12 + i*table_entry::byte_size);
+        if(entry.tag == t)
+        {
+            return {entry.offset, entry.length};
+        }
+    }
+
+    return {};
+}
+
+font_error validate_tables(font_data const & data, std::size_t font_offset)
+{
+    if(!valid_table_directory(data, font_offset))
+        return font_error::bad_table_directory;
+
+    auto const cmap = find_table(data, font_offset, "cmap");
+    auto const head = find_table(data, font_offset, "head");
+    auto const maxp = find_table(data, font_offset, "maxp");
+    auto const hhea = find_table(data, font_offset, "hhea");
+    auto const hmtx = find_table(data, font_offset, "hmtx");
+    auto const loca = find_table(data, font_offset, "loca");
+    auto const glyf = find_table(data, font_offset, "glyf");
+
+    if(cmap.empty() || head.empty() || maxp.empty() || hhea.empty() ||
+        hmtx.empty() || loca.empty() || glyf.empty())
+        return font_error::missing_table;
+
+    if(!head.contains(head.offset, 54) ||
+        !maxp.contains(maxp.offset, 6) ||
+        !hhea.contains(hhea.offset, 36))
+        return font_error::bad_header;
+
+    if(!data.load(head.offset, head.length) ||
+        !data.load(maxp.offset, maxp.length) ||
+        !data.load(hhea.offset, hhea.length))
+        return font_error::bad_file;
+
+    auto const index_to_loc_format = data.get<std::uint16_t>(head.offset + 50);
+    if(index_to_loc_format > 1)
+        return font_error::bad_header;
+
+    auto const num_glyphs = data.get<std::uint16_t>(maxp.offset + 4);
+    auto const num_h_metrics = data.get<std::uint16_t>(hhea.offset + 34);
+    if(num_glyphs > 0 && num_h_metrics == 0)
+        return font_error::bad_metrics;
+
+    auto const num_lsbs =
+        num_glyphs > num_h_metrics ? num_glyphs - num_h_metrics : 0u;
+    if(!hmtx.contains(hmtx.offset, num_h_metrics * 4u + num_lsbs * 2u))
+        return font_error::bad_metrics;
+
+    if(!data.load(hmtx.offset, num_h_metrics * 4u + num_lsbs * 2u))
+        return font_error::bad_file;
+
+    return font_error::none;
+}
+
+bool valid_cmap(font_data const & data, table const & cmap)
+{
+    if(!cmap.contains(cmap.offset, 4))
+        return false;
+
+    if(!data.load(cmap.offset, cmap.length))
+        return false;
+
+    auto const num_tables = data.get<std::uint16_t>(cmap.offset + 2);
+    auto const records = cmap.offset + 4;
+    if(!cmap.contains(records, num_tables * encoding_record::byte_size))
+        return false;
+
+    // Any of the subtables may be picked for lookups. Subtables of formats,
+    // which are never used, are not checked further.
+    for(auto i = 0u; i != num_tables; ++i)
+    {
+        auto const record = data.get<encoding_record>(
+            records + i*encoding_record::byte_size);
+        auto const sub = cmap.offset + record.subtable_offset;
+        if(!cmap.contains(sub, 2))
+            return false;
+
+        auto valid = true;
+        switch(data.get<std::uint16_t>(sub))
+        {
+            case 0:
+                valid = valid_format0_cmap(data, cmap, sub);
+                break;
+            case 4:
+                valid = valid_format4_cmap(data, cmap, sub);
+                break;
+            case 6:
+                valid = valid_format6_cmap(data, cmap, sub);
+                break;
+            default:
+                break;
+        }
+
+        if(!valid)
+            return false;
+    }
+
+    return true;
+}
+
+font_error validate_loca(
+    table const & loca, std::uint16_t index_to_loc_format,
+    std::size_t num_glyphs)
+{
+    auto const entry_size = index_to_loc_format == 0 ? 2u : 4u;
+    if(!loca.contains(loca.offset, (num_glyphs + 1) * entry_size))
+        return font_error::bad_loca;
+
+    return font_error::none;
+}
+
+font_error validate_glyph(
+    font_data const & data, table const & loca, table const & glyf,
+    std::uint16_t index_to_loc_format, std::size_t num_glyphs,
+    std::size_t glyph_index)
+{
+    auto const entry_size = index_to_loc_format == 0 ? 2u : 4u;
+    auto const location = [&data, &loca, entry_size](std::size_t i)
+        -> std::size_t
+    {
+        auto const offs = loca.offset + i * entry_size;
+        return entry_size == 2 ?
+            data.get<std::uint16_t>(offs) * std::size_t{2} :
+            data.get<std::uint32_t>(offs);
+    };
+
+    if(!data.load(loca.offset + glyph_index * entry_size, 2 * entry_size))
+        return font_error::bad_file;
+
+    auto const start = location(glyph_index);
+    auto const end = location(glyph_index + 1);
+    if(end < start || end > glyf.length)
+        return font_error::bad_loca;
+
+    if(end == start)
+        return font_error::none;
+
+    auto const glyph = table{glyf.offset + start, end - start};
+    if(glyph.length < glyph_header::byte_size)
+        return font_error::bad_glyph;
+
+    if(!data.load(glyph.offset, glyph.length))
+        return font_error::bad_file;
+
+    auto const num_contours = data.get<std::int16_t>(glyph.offset);
+    if(num_contours > 0 && !valid_simple_glyph(data, glyph))
+        return font_error::bad_glyph;
+
+    if(num_contours < 0 && !valid_composite_glyph(data, glyph, num_glyphs))
+        return font_error::bad_glyph;
+
+    return font_error::none;
+}
+
+font_error validate_glyphs(
+    font_data const & data, table const & loca, table const & glyf,
+    std::uint16_t index_to_loc_format, std::size_t num_glyphs)
+{
+    auto const error = validate_loca(loca, index_to_loc_format, num_glyphs);
+    if(error != font_error::none)
+        return error;
+
+    for(auto i = std::size_t{0}; i != num_glyphs; ++i)
+    {
+        auto const glyph_error = validate_glyph(
+            data, loca, glyf, index_to_loc_format, num_glyphs, i);
+        if(glyph_error != font_error::none)
+            return glyph_error;
+    }
+
+    return font_error::none;
+}
+
+bool valid_kern(font_data const & data, table const & kern)
+{
+    if(!kern.contains(kern.offset, 4))
+        return false;
+
+    if(!data.load(kern.offset, kern.length))
+        return false;
+
+    auto const version = data.get<std::uint16_t>(kern.offset);
+    auto const n_tables = data.get<std::uint16_t>(kern.offset + 2);
+    if(version != 0)
+        return true; // Not read at all
+
+    // Same walk as when reading the kerning pairs
+    auto offset = kern.offset + 4;
+    for(auto i = 0u; i != n_tables; ++i)
+    {
+        if(!kern.contains(offset, 6))
+            return false;
+
+        auto const sub_version = data.get<std::uint16_t>(offset);
+        auto const length = data.get<std::uint16_t>(offset + 2);
+        auto const coverage = data.get<std::uint16_t>(offset + 4);
+        if(sub_version == 0 && (coverage >> 8) == 0 && (coverage & 1) != 0)
+        {
+            if(!kern.contains(offset, 14))
+                return false;
+
+            auto const n_pairs = data.get<std::uint16_t>(offset + 6);
+            return kern.contains(offset + 14, n_pairs * std::size_t{6});
+        }
+
+        offset += length;
+    }
+
+    return true;
+}
+
+} /* namespace detail */
+
+} /* namespace wttf */
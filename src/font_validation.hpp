@@ -0,0 +1,76 @@
+#ifndef WTTF_FONT_VALIDATION_HPP
+#define WTTF_FONT_VALIDATION_HPP
+
+#include <wttf/typeface.hpp>
+#include "font_data.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+/*
+ * Checks that everything typeface reads from the font is inside the data.
+ * Once a table passes, the parser can read it without bounds checks. Data
+ * read from a file is loaded as it is checked, so the parser reads only
+ * loaded data. Parts of the file, which can't be read, fail the check.
+ */
+
+// Position of a table, or of a glyph record, in the font data
+struct table
+{
+    std::size_t offset{0};
+    std::size_t length{0};
+
+    [[nodiscard]] bool empty() const { return length == 0; }
+
+    // Tells if size bytes at offs, an offset into the font data, are inside
+    [[nodiscard]] bool contains(std::size_t offs, std::size_t size) const
+    {
+        return
+            offs >= offset && offs - offset <= length &&
+            size <= length - (offs - offset);
+    }
+};
+
+// Table with the tag, in the font at font_offset. Assumes that the table
+// directory is valid.
+[[nodiscard]] table find_table(
+    font_data const & data, std::size_t font_offset, char const * tag);
+
+// Table directory, presence of the required tables, and the head, maxp,
+// hhea and hmtx tables. Cheap enough to check when constructing a typeface.
+[[nodiscard]] font_error validate_tables(
+    font_data const & data, std::size_t font_offset);
+
+// Subtables of cmap, which may be used for lookups
+[[nodiscard]] bool valid_cmap(font_data const & data, table const & cmap);
+
+// Size of loca, so that locations of all glyphs can be read
+[[nodiscard]] font_error validate_loca(
+    table const & loca, std::uint16_t index_to_loc_format,
+    std::size_t num_glyphs);
+
+// Location and record of one glyph. Assumes that loca is valid.
+[[nodiscard]] font_error validate_glyph(
+    font_data const & data, table const & loca, table const & glyf,
+    std::uint16_t index_to_loc_format, std::size_t num_glyphs,
+    std::size_t glyph_index);
+
+// loca and all glyph records, including components of composite glyphs
+[[nodiscard]] font_error validate_glyphs(
+    font_data const & data, table const & loca, table const & glyf,
+    std::uint16_t index_to_loc_format, std::size_t num_glyphs);
+
+// The kern subtable, from which kerning pairs are read
+[[nodiscard]] bool valid_kern(font_data const & data, table const & kern);
+
+} /* namespace detail */
+
+} /* namespace wttf */
+
+#endif /* WTTF_FONT_VALIDATION_HPP */
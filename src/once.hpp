@@ -0,0 +1,45 @@
+#ifndef WTTF_ONCE_HPP
+#define WTTF_ONCE_HPP
+
+#include <atomic>
+#include <mutex>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+/*
+ * Runs a function once, for initializing something on first use from any
+ * number of threads. Other threads calling meanwhile wait until the first
+ * call has finished. After that, a call costs only an atomic load.
+ */
+class once_flag
+{
+    public:
+    template <typename Function>
+    void call(Function && function)
+    {
+        if(m_done.load(std::memory_order_acquire))
+            return;
+
+        std::call_once(
+            m_flag,
+            [this, &function]()
+            {
+                function();
+                m_done.store(true, std::memory_order_release);
+            });
+    }
+
+    private:
+    std::once_flag m_flag{};
+    std::atomic<bool> m_done{false};
+};
+
+} /* namespace detail */
+
+} /* namespace wttf */
+
+#endif /* WTTF_ONCE_HPP */
@@ -0,0 +1,103 @@
+#include <wttf/outline.hpp>
+#include <wttf/assert.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace wttf
+{
+
+/* Class: outline */
+void outline::add_contour(std::size_t s)
+{
+    m_contour_ends.push_back(static_cast<std::uint32_t>(m_points.size()));
+
+    if(s)
+    {
+        m_points.reserve(m_points.size() + s);
+        m_on_curve.reserve((m_points.size() + s + 7) / 8);
+    }
+}
+
+void outline::add_vertex(std::int16_t x, std::int16_t y, bool on_curve)
+{
+    WTTF_ASSERT(!m_contour_ends.empty());
+
+    auto const i = m_points.size();
+    if(i == 0)
+    {
+        m_min_x = m_max_x = x;
+        m_min_y = m_max_y = y;
+    }
+    else
+    {
+        m_min_x = std::min(m_min_x, x);
+        m_min_y = std::min(m_min_y, y);
+        m_max_x = std::max(m_max_x, x);
+        m_max_y = std::max(m_max_y, y);
+    }
+
+    m_points.push_back({x, y});
+    if(i % 8 == 0)
+    {
+        m_on_curve.push_back(0);
+    }
+
+    if(on_curve)
+    {
+        m_on_curve.back() |= static_cast<std::uint8_t>(1u << (i % 8));
+    }
+
+    m_contour_ends.back() = static_cast<std::uint32_t>(m_points.size());
+}
+
+void outline::shrink_to_fit()
+{
+    m_points.shrink_to_fit();
+    m_on_curve.shrink_to_fit();
+    m_contour_ends.shrink_to_fit();
+}
+
+std::size_t outline::size_in_bytes() const
+{
+    return
+        m_points.size() * sizeof(coordinate) +
+        m_on_curve.size() +
+        m_contour_ends.size() * sizeof(std::uint32_t);
+}
+
+/* Class: outline_view */
+shape outline_view::to_shape() const
+{
+    auto result = shape{
+        static_cast<float>(m_min_x), static_cast<float>(m_min_y),
+        static_cast<float>(m_max_x), static_cast<float>(m_max_y),
+        num_contours()};
+
+    for(auto c = std::size_t{0}; c != num_contours(); ++c)
+    {
+        auto const first = contour_start(c);
+        auto const last = contour_end(c);
+        result.add_contour(last - first);
+
+        for(auto i = first; i != last; ++i)
+        {
+            auto const & p = position(i);
+            result.add_vertex(
+                static_cast<float>(p.x), static_cast<float>(p.y),
+                on_curve(i));
+        }
+    }
+
+    return result;
+}
+
+shape outline_view::to_shape(transform const & t) const
+{
+    auto result = to_shape();
+    result.transform(t);
+    return result;
+}
+
+} /* namespace wttf */
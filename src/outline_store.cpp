@@ -0,0 +1,33 @@
+#include <wttf/outline_store.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace wttf
+{
+
+outline_view outline_store::operator[](std::uint16_t glyph_index) const
+{
+    if(!contains(glyph_index))
+        return {};
+
+    auto const & e = m_entries[m_index[glyph_index]];
+    return {
+        m_points.data() + e.first_point,
+        m_on_curve.data() + e.first_flag_byte,
+        m_contour_ends.data() + e.first_contour,
+        e.num_contours,
+        e.min_x, e.min_y, e.max_x, e.max_y};
+}
+
+std::size_t outline_store::size_in_bytes() const
+{
+    return
+        m_index.size() * sizeof(std::uint32_t) +
+        m_entries.size() * sizeof(entry) +
+        m_points.size() * sizeof(outline_view::coordinate) +
+        m_on_curve.size() +
+        m_contour_ends.size() * sizeof(std::uint32_t);
+}
+
+} /* namespace wttf */
@@ -0,0 +1,79 @@
+#ifndef WTTF_PARALLEL_HPP
+#define WTTF_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace wttf
+{
+
+namespace detail
+{
+
+/*
+ * Calls function(i) for each i in [0, count), on up to threads threads,
+ * including the calling thread. Zero threads means one per hardware thread.
+ * Indices are handed out in blocks, so uneven work is balanced between the
+ * threads. Function must be safe to call concurrently for distinct indices.
+ */
+template <typename Function>
+void parallel_for(
+    std::size_t count, std::size_t threads, Function const & function)
+{
+    constexpr auto block_size = std::size_t{64};
+
+    if(threads == 0)
+    {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threads = std::min(threads, (count + block_size - 1) / block_size);
+
+    if(threads <= 1)
+    {
+        for(auto i = std::size_t{0}; i != count; ++i)
+        {
+            function(i);
+        }
+        return;
+    }
+
+    auto next = std::atomic<std::size_t>{0};
+    auto const work = [count, &next, &function]()
+    {
+        for(;;)
+        {
+            auto const first = next.fetch_add(block_size);
+            if(first >= count)
+                return;
+
+            auto const last = std::min(first + block_size, count);
+            for(auto i = first; i != last; ++i)
+            {
+                function(i);
+            }
+        }
+    };
+
+    auto workers = std::vector<std::thread>{};
+    workers.reserve(threads - 1);
+    for(auto i = std::size_t{1}; i != threads; ++i)
+    {
+        workers.emplace_back(work);
+    }
+
+    work();
+
+    for(auto & w: workers)
+    {
+        w.join();
+    }
+}
+
+} /* namespace detail */
+
+} /* namespace wttf */
+
+#endif /* WTTF_PARALLEL_HPP */
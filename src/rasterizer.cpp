@@ -1,11 +1,22 @@
 #include <wttf/rasterizer.hpp>
 #include <wttf/assert.hpp>
+#include <wttf/outline.hpp>
+#include "blend.hpp"
+#include "coverage_kernel.hpp"
+#include "fixed_vector.hpp"
+#include "typeface_p.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
 #include <limits>
+#include <optional>
+#include <type_traits>
+#include <variant>
 #include <vector>
 #include <utility>
 
@@ -16,22 +27,66 @@ namespace wttf
 class rasterizer::implementation
 {
     public:
+    using target_t = std::variant<
+        std::monostate,
+        image_view<pixel_format::a8>,
+        image_view<pixel_format::rgba8>,
+        image_view<pixel_format::bgra8>,
+        image_view<pixel_format::float_coverage>>;
+
     implementation() = default;
     implementation(implementation const &) = default;
     implementation(implementation &&) = default;
 
-    implementation(
-        std::uint8_t * image,
-        std::size_t width,
-        std::size_t height,
-        std::ptrdiff_t stride):
-        m_image{image},
+    template <typename Format>
+    explicit implementation(image_view<Format> const & target):
+        m_target{target},
+        m_width{target.data ? target.width : 0},
+        m_height{target.data ? target.height : 0},
+        m_clip{0, m_width, 0, m_height}
+    {}
+
+    implementation(std::size_t width, std::size_t height):
         m_width{width},
         m_height{height},
-        m_stride{stride}
+        m_clip{0, m_width, 0, m_height}
     {}
 
-    void rasterize(shape const & s, float x_offset, float y_offset) const;
+    void rasterize(
+        shape const & s, float x_offset, float y_offset,
+        paint const & p) const;
+    void rasterize(
+        shape const & s, float x_offset, float y_offset,
+        span_sink & sink) const;
+    void rasterize(
+        shape const & s, transform const & t, paint const & p) const;
+    void rasterize(
+        shape const & s, transform const & t, span_sink & sink) const;
+    void rasterize(
+        outline_view const & o, transform const & t, paint const & p) const;
+    void rasterize(
+        outline_view const & o, transform const & t, span_sink & sink) const;
+    void rasterize_glyph(
+        typeface::implementation const & face, std::uint16_t glyph_index,
+        transform const & t, paint const & p) const;
+    void rasterize_bands(
+        shape const & s, float x_offset, float y_offset,
+        std::size_t band_height, band_callback const & callback) const;
+    coverage_mask rasterize_mask(
+        shape const & s, float x_offset, float y_offset) const;
+    void blit(
+        coverage_mask const & mask,
+        std::ptrdiff_t x_offset, std::ptrdiff_t y_offset,
+        paint const & p) const;
+
+    [[nodiscard]] raster_engine engine() const { return m_engine; }
+    void set_engine(raster_engine e) { m_engine = e; }
+    [[nodiscard]] wttf::fill_rule fill_rule() const { return m_fill_rule; }
+    void set_fill_rule(wttf::fill_rule r) { m_fill_rule = r; }
+    [[nodiscard]] std::size_t width() const { return m_width; }
+    [[nodiscard]] std::size_t height() const { return m_height; }
+    [[nodiscard]] clip_rect clip() const;
+    void set_clip(clip_rect const & r);
 
     private:
     struct line_segment
@@ -43,12 +98,224 @@ class rasterizer::implementation
         int winding;
     };
 
-    std::vector <line_segment> create_lines(
+    class sink_adapter;
+
+    // Area of pixels to rasterize, [start, end) on both axes
+    struct pixel_rect
+    {
+        std::size_t start_x;
+        std::size_t end_x;
+        std::size_t start_y;
+        std::size_t end_y;
+    };
+
+    std::optional<pixel_rect> pixel_bounds(
+        shape const & s, float x_offset, float y_offset) const;
+    std::optional<pixel_rect> pixel_bounds(
+        float min_x, float min_y, float max_x, float max_y) const;
+    // Pixels covered by the rectangle, transformed by t
+    std::optional<pixel_rect> transformed_bounds(
+        float min_x, float min_y, float max_x, float max_y,
+        transform const & t) const;
+
+    // Calls function with span_blender for the target and the paint
+    template <typename Function>
+    void with_blender(paint const & p, Function && function) const;
+
+    template <typename Output>
+    void rasterize(
+        shape const & s, float x_offset, float y_offset,
+        Output & output) const;
+    template <typename Output>
+    void rasterize(
+        shape const & s, transform const & t, Output & output) const;
+    template <typename Output>
+    void rasterize(
+        outline_view const & o, transform const & t, Output & output) const;
+    template <typename Output>
+    void rasterize_glyph(
+        typeface::implementation const & face, std::uint16_t glyph_index,
+        transform const & t, Output & output) const;
+
+    /*
+     * Rasterizes an outline, which decode_outline(builder) feeds to an
+     * outline_flattener. If small is set, the outline is first tried with
+     * buffers on the stack.
+     */
+    template <typename Decode, typename Output>
+    void rasterize_outline(
+        Decode const & decode_outline, bool small, Output & output) const;
+
+    /*
+     * Produces the bands from the edges of a whole shape. Each band is
+     * rasterized from band_edges, an empty list of the same kind, holding
+     * only the edges, which cross the band.
+     */
+    template <typename Edge, typename Edges>
+    void rasterize_bands(
+        pixel_rect const & bounds, std::vector<Edge> edges,
+        Edges & band_edges, std::size_t band_height,
+        band_callback const & callback) const;
+
+    template <typename Blender>
+    void blit(
+        coverage_mask const & mask,
+        std::ptrdiff_t x_offset, std::ptrdiff_t y_offset,
+        Blender const & blender) const;
+
+    /*
+     * Storage for edge lists and the buffers of rasterize_scanlines. Small
+     * shapes, which fit in small_size x small_size pixels and have at most
+     * small_max_edges edges, are rasterized with everything on the stack.
+     */
+    struct heap_storage
+    {
+        template <typename T>
+        using vector = std::vector<T>;
+    };
+
+    template <std::size_t Capacity>
+    struct stack_storage
+    {
+        template <typename T>
+        using vector = detail::fixed_vector<T, Capacity>;
+    };
+
+    static constexpr std::size_t small_size = 32;
+    static constexpr std::size_t small_max_edges = 256;
+    using small_storage = stack_storage<small_max_edges>;
+
+    static bool is_small(pixel_rect const & r)
+    {
+        return
+            r.end_x - r.start_x <= small_size &&
+            r.end_y - r.start_y <= small_size;
+    }
+
+    static std::size_t edge_count(shape const & s);
+
+    /*
+     * Edge lists of the engines, built one line at a time. Lines, which
+     * can not affect pixels in the clip rectangle, are dropped. finish()
+     * sorts the edges for rasterize_scanlines.
+     */
+    template <typename Storage = heap_storage>
+    class line_list
+    {
+        public:
+        explicit line_list(pixel_rect const & clip);
+
+        void add(float x1, float y1, float x2, float y2);
+        void finish();
+
+        typename Storage::template vector<line_segment> edges{};
+
+        private:
+        float m_clip_x2;
+        float m_clip_y1;
+        float m_clip_y2;
+    };
+
+    template <typename Storage = heap_storage>
+    class fixed_edge_list;
+
+    // Flattens curves of an outline into an edge list
+    template <typename Edges>
+    class outline_flattener;
+
+    // Adds the edges of a shape, moved by x and y, to an edge list
+    template <typename Edges>
+    static void add_edges(Edges & edges, shape const & s, float x, float y);
+
+    line_list<> create_lines(shape const & s, float x, float y) const;
+    template <typename Storage, typename Output>
+    void rasterize_scanlines(
+        std::size_t const start_x, std::size_t const end_x,
+        std::size_t const start_y, std::size_t const end_y,
+        line_list<Storage> const & lines,
+        Output & output) const;
+
+    /*
+     * Fixed-point engine. Coordinates are 24.8 fixed-point numbers and
+     * coverage is accumulated as integer signed area, so the output does
+     * not depend on the compiler or the CPU.
+     */
+    static constexpr std::int32_t fixed_shift = 8;
+    static constexpr std::int32_t fixed_one = 1 << fixed_shift;
+    // Twice the area of a pixel, in fixed-point units
+    static constexpr std::int32_t fixed_full_area = 2*fixed_one*fixed_one;
+
+    struct fixed_edge
+    {
+        std::int32_t x1;
+        std::int32_t y1; // y1 < y2
+        std::int32_t x2;
+        std::int32_t y2;
+        std::int64_t dxdy; // 16.16
+        std::int64_t dydx; // 16.16
+        std::int32_t winding;
+
+        std::int32_t x_at(std::int32_t y) const;
+        std::int32_t y_at(std::int32_t x) const;
+    };
+
+    template <typename Storage>
+    class fixed_edge_list
+    {
+        public:
+        explicit fixed_edge_list(pixel_rect const & clip);
+
+        void add(float x1, float y1, float x2, float y2);
+        void finish();
+
+        typename Storage::template vector<fixed_edge> edges{};
+
+        private:
+        std::int32_t m_clip_x2;
+        std::int32_t m_clip_y1;
+        std::int32_t m_clip_y2;
+    };
+
+    fixed_edge_list<> create_fixed_edges(
         shape const & s, float x, float y) const;
+    template <typename Storage, typename Output>
+    void rasterize_scanlines(
+        std::size_t const start_x, std::size_t const end_x,
+        std::size_t const start_y, std::size_t const end_y,
+        fixed_edge_list<Storage> const & edges,
+        Output & output) const;
+    static void accumulate_fixed(
+        fixed_edge const & e, std::int32_t row, std::size_t start_x,
+        std::int32_t * acc, std::size_t acc_size);
+
+    // Whether an edge crosses any of the rows [start_y, end_y)
+    static bool crosses_rows(
+        line_segment const & l, std::size_t start_y, std::size_t end_y);
+    static bool crosses_rows(
+        fixed_edge const & e, std::size_t start_y, std::size_t end_y);
+
+    /*
+     * Tiled engine. Uses the coverage math of the fixed-point engine, but
+     * the area is split into square tiles. Only tiles that edges pass
+     * through are resolved pixel by pixel; other tiles have uniform
+     * coverage and are output as single spans, and bands of tiles without
+     * any edges are skipped altogether. Spans of no coverage are not
+     * output; in replace mode each band of tiles is cleared at once
+     * instead.
+     */
+    static constexpr std::size_t tile_size = 16;
+
+    struct tiled_edges
+    {
+        std::vector<fixed_edge> edges;
+    };
+
+    template <typename Output>
     void rasterize_scanlines(
         std::size_t const start_x, std::size_t const end_x,
         std::size_t const start_y, std::size_t const end_y,
-        std::vector<line_segment> const & lines) const;
+        tiled_edges const & tiled,
+        Output & output) const;
 
     struct edge_info
     {
@@ -86,229 +353,1931 @@ class rasterizer::implementation
         }
     };
 
+    /*
+     * Runs of pixels crossed by edges are resolved by the scanline kernel
+     * if they are at least this long, and pixel by pixel with
+     * edge_info::coverage otherwise. Both do the same float math, so the
+     * output is the same, but the kernel is not worth calling for the short
+     * runs of steep edges.
+     */
+    static constexpr std::size_t min_kernel_run = 8;
+
     edge_info clip(float const y1, line_segment seg) const;
 
-    std::uint8_t * m_image{nullptr};
+    struct active_line
+    {
+        line_segment const * line;
+        edge_info edge;
+    };
+
+    target_t m_target{};
     std::size_t m_width{0};
     std::size_t m_height{0};
-    std::ptrdiff_t m_stride{0};
+    pixel_rect m_clip;
+    raster_engine m_engine{raster_engine::floating_point};
+    wttf::fill_rule m_fill_rule{wttf::fill_rule::non_zero};
 }; /* class rasterizer::implementation */
 
-void rasterizer::implementation::rasterize(
-    shape const & s, float x_offset, float y_offset) const
+namespace
 {
-    auto const start_x = std::max(0.0f, std::floor(s.min_x() + x_offset));
-    auto const start_y = std::max(0.0f, std::floor(s.min_y() + y_offset));
-    auto const end_x = std::min(
-        static_cast<float>(m_width), std::ceil(s.max_x() + x_offset));
-    auto const end_y = std::min(
-        static_cast<float>(m_height), std::ceil(s.max_y() + y_offset));
 
-    // Early exit, if shape is out of bounds
-    if(start_x >= end_x || start_y >= end_y)
-        return;
+// Maximum distance of flattened curves from the real ones, squared, in pixels
+constexpr float flatness = 0.45f;
 
-    auto const & lines = create_lines(s, x_offset, y_offset);
-    rasterize_scanlines(
-        static_cast<std::size_t>(start_x), static_cast<std::size_t>(end_x),
-        static_cast<std::size_t>(start_y), static_cast<std::size_t>(end_y),
-        lines);
+// Coverage of a pixel from its accumulated signed area
+float resolve_coverage(float const area, fill_rule const rule)
+{
+    if(rule == fill_rule::even_odd)
+    {
+        auto const a = std::fmod(std::abs(area), 2.0f);
+        return a > 1.0f ? 2.0f - a : a;
+    }
+
+    return std::clamp(std::abs(area), 0.0f, 1.0f);
 }
 
-std::vector<rasterizer::implementation::line_segment>
-rasterizer::implementation::create_lines(
-    shape const & s,
-    float x_offset, float y_offset) const
+/*
+ * Stable sort of items by a small non-negative integer key, such as the
+ * first scanline of an edge. Bucket sort, linear in the number of items and
+ * the range of keys.
+ */
+template <typename T, typename Key>
+void sort_by_key(std::vector<T> & items, Key const & key)
 {
-    auto num_lines = std::size_t{0};
-    for(auto const & c: s)
+    if(items.size() < 2)
+        return;
+
+    auto min_key = std::numeric_limits<std::size_t>::max();
+    auto max_key = std::size_t{0};
+    for(auto const & item: items)
+    {
+        auto const k = key(item);
+        min_key = std::min(min_key, k);
+        max_key = std::max(max_key, k);
+    }
+
+    auto offsets = std::vector<std::size_t>(max_key - min_key + 2);
+    for(auto const & item: items)
     {
-        num_lines += c.size();
+        ++offsets[key(item) - min_key + 1];
     }
 
-    std::vector<line_segment> lines;
-    lines.reserve(num_lines);
+    for(auto k = std::size_t{1}; k != offsets.size(); ++k)
+    {
+        offsets[k] += offsets[k-1];
+    }
 
-    for(auto const & contour: s)
+    auto sorted = std::vector<T>(items.size());
+    for(auto const & item: items)
     {
-        for(auto i = 0u; i != contour.size(); ++i)
-        {
-            auto const & v1 = contour[i];
-            auto const & v2 = contour[(i+1) % contour.size()];
+        sorted[offsets[key(item) - min_key]++] = item;
+    }
 
-            // Ignore horizontal lines
-            if(v1.y == v2.y) 
-            {
-                continue;
-            }
+    items.swap(sorted);
+}
 
-            lines.push_back({
-                v1.x+x_offset, v1.y+y_offset,
-                v2.x+x_offset, v2.y+y_offset,
-                -1});
-            auto & l = lines.back();
-            if(l.y1 > l.y2)
-            {
-                std::swap(l.x1, l.x2);
-                std::swap(l.y1, l.y2);
-                l.winding = 1;
-            }
+// Same order as above, for the short lists of small shapes. Insertion sort
+// needs no extra buffers.
+template <typename T, std::size_t Capacity, typename Key>
+void sort_by_key(detail::fixed_vector<T, Capacity> & items, Key const & key)
+{
+    for(auto i = std::size_t{1}; i < items.size(); ++i)
+    {
+        auto const item = items[i];
+        auto const k = key(item);
+        auto j = i;
+        for(; j != 0 && key(items[j-1]) > k; --j)
+        {
+            items[j] = items[j-1];
         }
+        items[j] = item;
     }
+}
 
-    // Sort lines by their top position
-    auto const compare_line = [](auto const & a, auto const & b)
-    {
-        return a.y2 < b.y2;
-    };
+/*
+ * Whether an output changes pixels for spans of no coverage. Only blenders
+ * in replace mode do, by clearing them. Other blend modes, sink_adapter and
+ * the outputs of masks and bands ignore such spans.
+ */
+template <typename Output>
+constexpr bool writes_empty_spans = false;
 
-    std::sort(std::begin(lines), std::end(lines), compare_line);
+template <typename Format, blend_mode Mode>
+constexpr bool writes_empty_spans<detail::span_blender<Format, Mode>> =
+    Mode == blend_mode::replace;
 
-    return lines;
-}
+// Whether an output takes spans of 8-bit coverage for each pixel
+template <typename Output>
+constexpr bool copies_8bit_coverage = false;
 
-void rasterizer::implementation::rasterize_scanlines(
-        std::size_t const start_x, std::size_t const end_x,
-        std::size_t const start_y, std::size_t const end_y,
-        std::vector<line_segment> const & lines) const
+template <typename Format, blend_mode Mode>
+constexpr bool copies_8bit_coverage<detail::span_blender<Format, Mode>> =
+    std::is_same_v<typename Format::channel_type, std::uint8_t>;
+
+} /* namespace */
+
+/* Class: rasterizer::implementation::sink_adapter */
+class rasterizer::implementation::sink_adapter
 {
-    std::vector<edge_info> scanline_buffer;
-    auto line_it = std::cbegin(lines);
-    for(auto cy = start_y; cy < end_y; ++cy)
-    {
-        auto const fcy = static_cast<float>(cy);
+    public:
+    explicit sink_adapter(span_sink & sink):
+        m_sink{sink}
+    {}
 
-        scanline_buffer.clear();
-        auto const pred = [cy=static_cast<float>(cy)](auto const & l)
+    void operator()(
+        std::size_t y, std::size_t x, std::size_t count,
+        float coverage)
+    {
+        if(y != m_y)
         {
-            return l.y2 > cy;
-        };
-        line_it = std::find_if(line_it, std::cend(lines), pred);
+            flush();
+            m_y = y;
+        }
 
-        for(auto i = line_it; i != std::cend(lines); ++i)
+        if(coverage > 0.0f)
         {
-            if(i->y1 >= (fcy+1.0f))
-                continue;
-            scanline_buffer.push_back(clip(fcy, *i));
+            m_spans.push_back({x, x+count, coverage});
         }
+    }
 
-        auto const compare_edge = [](auto const & a, auto const & b)
+    void flush()
+    {
+        if(!m_spans.empty())
         {
-            return a.x2 < b.x2;
-        };
+            m_sink.row(m_y, m_spans.data(), m_spans.size());
+            m_spans.clear();
+        }
+    }
 
+    private:
+    span_sink & m_sink;
+    std::vector<span> m_spans{};
+    std::size_t m_y{0};
+}; /* class rasterizer::implementation::sink_adapter */
 
-        std::sort(
-            std::begin(scanline_buffer), std::end(scanline_buffer),
-            compare_edge);
+/* Class: rasterizer::implementation::outline_flattener */
+template <typename Edges>
+class rasterizer::implementation::outline_flattener
+{
+    public:
+    outline_flattener(Edges & edges, float flatness):
+        m_edges{edges},
+        m_flatness{flatness}
+    {}
 
-        auto coverage1 = 0.0f;
-        auto sbuf_it = std::cbegin(scanline_buffer);
+    void add_contour(std::size_t)
+    {
+        close();
+        m_first_vertex = true;
+    }
 
-        for(auto cx = start_x; cx < end_x;)
+    // Same rules as in shape::flatten
+    void add_vertex(float x, float y, bool on_curve)
+    {
+        if(m_first_vertex)
         {
-            auto const fcx = static_cast<float>(cx);
+            m_first_vertex = false;
+            m_prev_on_curve = true;
+            m_has_point = false;
+            m_first_x = x;
+            m_first_y = y;
+            m_ex = x;
+            m_ey = y;
+        }
 
-            while(
-                sbuf_it != std::cend(scanline_buffer) &&
-                sbuf_it->x2 < fcx)
+        if(on_curve)
+        {
+            if(m_prev_on_curve)
             {
-                coverage1 += sbuf_it->coverage(fcx);
-                ++sbuf_it;
+                line_to(x, y);
+            }
+            else
+            {
+                curve_to(m_ex, m_ey, m_cx, m_cy, x, y);
             }
 
-            auto coverage2 = 0.0f;
-            auto next_x1 = static_cast<float>(end_x);
-            for(auto it = sbuf_it; it != std::cend(scanline_buffer); ++it)
+            m_ex = x;
+            m_ey = y;
+        }
+        else
+        {
+            if(!m_prev_on_curve)
             {
-                if((fcx+1.0f) >=it->x1)
-                {
-                    coverage2 += it->coverage(fcx);
-                    next_x1 = fcx+1.0f;
-                }
-                else
-                {
-                    next_x1 = std::min(next_x1, it->x1);
-                }
+                auto const nx = (x+m_cx)/2.0f;
+                auto const ny = (y+m_cy)/2.0f;
+                curve_to(m_ex, m_ey, m_cx, m_cy, nx, ny);
+                m_ex = nx;
+                m_ey = ny;
             }
 
-            next_x1 = std::floor(next_x1);
-            WTTF_ASSERT(next_x1 > fcx);
+            m_cx = x;
+            m_cy = y;
+        }
 
-            auto const next_cx = static_cast<std::size_t>(next_x1);
-            auto const out_count = next_cx - cx;
+        m_prev_on_curve = on_curve;
+    }
 
-            auto const coverage = coverage1 + coverage2;
-            auto const w = std::clamp(std::abs(coverage), 0.0f, 1.0f);
-            auto const out = std::min(255, static_cast<int>(w * 255.0f));
+    // Closes the last contour
+    void finish()
+    {
+        close();
+        m_first_vertex = true;
+    }
 
-            auto const start_of_row =
-                static_cast<std::ptrdiff_t>(cy) * m_stride;
-            auto const offset = static_cast<std::size_t>(start_of_row) + cx;
-            std::fill_n(&m_image[offset], out_count, out);
+    [[nodiscard]] float min_x() const { return m_min_x; }
+    [[nodiscard]] float min_y() const { return m_min_y; }
+    [[nodiscard]] float max_x() const { return m_max_x; }
+    [[nodiscard]] float max_y() const { return m_max_y; }
 
-            cx = next_cx;
+    private:
+    void line_to(float x, float y)
+    {
+        if(m_has_point)
+        {
+            m_edges.add(m_x, m_y, x, y);
         }
+        else
+        {
+            m_start_x = x;
+            m_start_y = y;
+            m_has_point = true;
+        }
+
+        m_x = x;
+        m_y = y;
+        m_min_x = std::min(m_min_x, x);
+        m_min_y = std::min(m_min_y, y);
+        m_max_x = std::max(m_max_x, x);
+        m_max_y = std::max(m_max_y, y);
     }
-}
 
-rasterizer::implementation::edge_info
-rasterizer::implementation::clip(float const y1, line_segment seg) const
-{
-    auto const y2 = y1+1.0f;
-    WTTF_ASSERT(seg.y2 > y1 && seg.y1 < y2);
+    void curve_to(
+        float x0, float y0,
+        float x1, float y1,
+        float x2, float y2,
+        bool add_end_point = true)
+    {
+        // Middle of curve
+        auto const mx = (x0 + 2.0f*x1 + x2) / 4.0f;
+        auto const my = (y0 + 2.0f*y1 + y2) / 4.0f;
 
-    auto const dy = seg.y2 - seg.y1;
-    auto const fdx = (seg.x2 - seg.x1)/dy;
+        // Vector from middle of curve to direct line
+        auto const dx = (x0+x2)/2.0f - mx;
+        auto const dy = (y0+y2)/2.0f - my;
 
-    if(seg.y1 < y1)
-    {
-        seg.x1 += fdx * (y1 - seg.y1);
-        seg.y1 = y1;
+        if(dx*dx+dy*dy > m_flatness)
+        {
+            curve_to(x0, y0, (x0+x1)/2.0f, (y0+y1)/2.0f, mx, my);
+            curve_to(
+                mx, my, (x1+x2)/2.0f, (y1+y2)/2.0f, x2, y2, add_end_point);
+        }
+        else if(add_end_point)
+        {
+            line_to(x2, y2);
+        }
     }
 
-    if(seg.y2 > y2)
+    void close()
     {
-        seg.x2 += fdx * (y2 - seg.y2);
-        seg.y2 = y2;
+        if(m_first_vertex)
+            return;
+
+        if(!m_prev_on_curve)
+        {
+            curve_to(m_ex, m_ey, m_cx, m_cy, m_first_x, m_first_y, false);
+        }
+
+        if(m_has_point)
+        {
+            m_edges.add(m_x, m_y, m_start_x, m_start_y);
+        }
     }
 
-    auto const x1 = std::min(seg.x1, seg.x2);
-    auto const x2 = std::max(seg.x1, seg.x2);
-    auto const h = (seg.y2 - seg.y1) * static_cast<float>(seg.winding);
+    Edges & m_edges;
+    float m_flatness;
+    bool m_first_vertex{true};
+    bool m_prev_on_curve{true};
+    bool m_has_point{false};
+    float m_first_x{0.0f};
+    float m_first_y{0.0f};
+    float m_start_x{0.0f};
+    float m_start_y{0.0f};
+    float m_x{0.0f};
+    float m_y{0.0f};
+    float m_cx{0.0f};
+    float m_cy{0.0f};
+    float m_ex{0.0f};
+    float m_ey{0.0f};
+    float m_min_x{std::numeric_limits<float>::max()};
+    float m_min_y{std::numeric_limits<float>::max()};
+    float m_max_x{std::numeric_limits<float>::lowest()};
+    float m_max_y{std::numeric_limits<float>::lowest()};
+}; /* class rasterizer::implementation::outline_flattener */
 
-    return {x1, x2, h};
+void rasterizer::implementation::rasterize(
+    shape const & s, float x_offset, float y_offset, paint const & p) const
+{
+    with_blender(
+        p,
+        [&](auto & output)
+        {
+            rasterize(s, x_offset, y_offset, output);
+        });
 }
 
-/* Class: rasterizer */
-rasterizer::rasterizer() = default;
-rasterizer::rasterizer(rasterizer &&) = default;
+void rasterizer::implementation::rasterize(
+    shape const & s, float x_offset, float y_offset, span_sink & sink) const
+{
+    auto adapter = sink_adapter{sink};
+    rasterize(s, x_offset, y_offset, adapter);
+    adapter.flush();
+}
 
-rasterizer::rasterizer(
-    std::uint8_t * image,
-    std::size_t width,
-    std::size_t height,
-    std::ptrdiff_t stride):
-    m_impl{std::make_unique<implementation>(image, width, height, stride)}
-{}
+void rasterizer::implementation::rasterize(
+    shape const & s, transform const & t, paint const & p) const
+{
+    with_blender(
+        p,
+        [&](auto & output)
+        {
+            rasterize(s, t, output);
+        });
+}
 
-rasterizer::~rasterizer() = default;
+void rasterizer::implementation::rasterize(
+    shape const & s, transform const & t, span_sink & sink) const
+{
+    auto adapter = sink_adapter{sink};
+    rasterize(s, t, adapter);
+    adapter.flush();
+}
 
-rasterizer & rasterizer::operator=(rasterizer &&) = default;
+void rasterizer::implementation::rasterize(
+    outline_view const & o, transform const & t, paint const & p) const
+{
+    with_blender(
+        p,
+        [&](auto & output)
+        {
+            rasterize(o, t, output);
+        });
+}
 
-void rasterizer::rasterize(
-    shape const & s, float x_offset, float y_offset) const
+void rasterizer::implementation::rasterize(
+    outline_view const & o, transform const & t, span_sink & sink) const
 {
-    if(!m_impl)
+    auto adapter = sink_adapter{sink};
+    rasterize(o, t, adapter);
+    adapter.flush();
+}
+
+void rasterizer::implementation::rasterize_glyph(
+    typeface::implementation const & face, std::uint16_t glyph_index,
+    transform const & t, paint const & p) const
+{
+    with_blender(
+        p,
+        [&](auto & output)
+        {
+            rasterize_glyph(face, glyph_index, t, output);
+        });
+}
+
+template <typename Function>
+void rasterizer::implementation::with_blender(
+    paint const & p, Function && function) const
+{
+    using detail::span_blender;
+
+    std::visit(
+        [&](auto const & target)
+        {
+            using target_type = std::decay_t<decltype(target)>;
+            if constexpr(!std::is_same_v<target_type, std::monostate>)
+            {
+                using format = typename target_type::format;
+
+                switch(p.mode)
+                {
+                    case blend_mode::replace:
+                    {
+                        auto b = span_blender<format, blend_mode::replace>{
+                            target, p};
+                        function(b);
+                        break;
+                    }
+                    case blend_mode::max:
+                    {
+                        auto b = span_blender<format, blend_mode::max>{
+                            target, p};
+                        function(b);
+                        break;
+                    }
+                    case blend_mode::add:
+                    {
+                        auto b = span_blender<format, blend_mode::add>{
+                            target, p};
+                        function(b);
+                        break;
+                    }
+                    case blend_mode::source_over:
+                    {
+                        auto b = span_blender<format, blend_mode::source_over>{
+                            target, p};
+                        function(b);
+                        break;
+                    }
+                }
+            }
+        },
+        m_target);
+}
+
+template <typename Output>
+void rasterizer::implementation::rasterize(
+    shape const & s, float x_offset, float y_offset, Output & output) const
+{
+    auto const bounds = pixel_bounds(s, x_offset, y_offset);
+    if(!bounds)
         return;
 
-    if(!s.flat())
+    auto const rasterize_edges = [&bounds, &output, this](auto const & edges)
     {
-        rasterize(s.flatten(0.45f), x_offset, y_offset);
-        return;
-    }
+        rasterize_scanlines(
+            bounds->start_x, bounds->end_x, bounds->start_y, bounds->end_y,
+            edges, output);
+    };
 
-    m_impl->rasterize(s, x_offset, y_offset);
-}
+    // The tiled engine gives the same output as the fixed-point engine, and
+    // has no use for tiles in a small area.
+    if(is_small(*bounds) && edge_count(s) <= small_max_edges)
+    {
+        auto const rasterize_small = [&](auto && edges)
+        {
+            add_edges(edges, s, x_offset, y_offset);
+            edges.finish();
+            rasterize_edges(edges);
+        };
+
+        if(m_engine == raster_engine::floating_point)
+        {
+            rasterize_small(line_list<small_storage>{m_clip});
+        }
+        else
+        {
+            rasterize_small(fixed_edge_list<small_storage>{m_clip});
+        }
+        return;
+    }
+
+    switch(m_engine)
+    {
+        case raster_engine::floating_point:
+            rasterize_edges(create_lines(s, x_offset, y_offset));
+            break;
+        case raster_engine::fixed_point:
+            rasterize_edges(create_fixed_edges(s, x_offset, y_offset));
+            break;
+        case raster_engine::tiled:
+            rasterize_edges(
+                tiled_edges{create_fixed_edges(s, x_offset, y_offset).edges});
+            break;
+    }
+}
+
+template <typename Output>
+void rasterizer::implementation::rasterize(
+    shape const & s, transform const & t, Output & output) const
+{
+    if(s.empty())
+        return;
+
+    auto const box = transformed_bounds(
+        s.min_x(), s.min_y(), s.max_x(), s.max_y(), t);
+    auto const small =
+        (!box || is_small(*box)) &&
+        (!s.flat() || edge_count(s) <= small_max_edges);
+
+    rasterize_outline(
+        [&s, &t](auto & builder)
+        {
+            using builder_type = std::decay_t<decltype(builder)>;
+            auto transformed =
+                detail::transforming_builder<builder_type>{t, builder};
+
+            for(auto const & contour: s)
+            {
+                transformed.add_contour(contour.size());
+                for(auto const & v: contour)
+                {
+                    transformed.add_vertex(v.x, v.y, v.on_curve);
+                }
+            }
+        },
+        small, output);
+}
+
+template <typename Output>
+void rasterizer::implementation::rasterize(
+    outline_view const & o, transform const & t, Output & output) const
+{
+    if(o.empty())
+        return;
+
+    auto const box = transformed_bounds(
+        o.min_x(), o.min_y(), o.max_x(), o.max_y(), t);
+
+    rasterize_outline(
+        [&o, &t](auto & builder)
+        {
+            for(auto c = std::size_t{0}; c != o.num_contours(); ++c)
+            {
+                auto const first = o.contour_start(c);
+                auto const last = o.contour_end(c);
+                builder.add_contour(last - first);
+
+                for(auto i = first; i != last; ++i)
+                {
+                    auto const & p = o.position(i);
+                    auto const v = t.apply(p.x, p.y);
+                    builder.add_vertex(v.x, v.y, o.on_curve(i));
+                }
+            }
+        },
+        !box || is_small(*box), output);
+}
+
+template <typename Output>
+void rasterizer::implementation::rasterize_glyph(
+    typeface::implementation const & face, std::uint16_t glyph_index,
+    transform const & t, Output & output) const
+{
+    auto const m = face.metrics(glyph_index);
+    auto const box = transformed_bounds(m.x_min, m.y_min, m.x_max, m.y_max, t);
+
+    rasterize_outline(
+        [&face, glyph_index, &t](auto & builder)
+        {
+            face.decode_glyph(glyph_index, t, builder);
+        },
+        !box || is_small(*box), output);
+}
+
+template <typename Decode, typename Output>
+void rasterizer::implementation::rasterize_outline(
+    Decode const & decode_outline, bool small, Output & output) const
+{
+    // Decodes the outline into an edge list and returns the pixels to
+    // rasterize, if any
+    auto const decode = [&](auto & edges)
+    {
+        auto flattener = outline_flattener{edges, flatness};
+        decode_outline(flattener);
+        flattener.finish();
+        edges.finish();
+
+        return pixel_bounds(
+            flattener.min_x(), flattener.min_y(),
+            flattener.max_x(), flattener.max_y());
+    };
+
+    // Outlines, which are expected to be small, are decoded into edge lists
+    // on the stack. If the outline does not fit after all, it is decoded
+    // again below.
+    auto const rasterize_small = [&](auto && edges)
+    {
+        auto const bounds = decode(edges);
+        if(edges.edges.overflow() || (bounds && !is_small(*bounds)))
+            return false;
+
+        if(bounds)
+        {
+            rasterize_scanlines(
+                bounds->start_x, bounds->end_x,
+                bounds->start_y, bounds->end_y,
+                edges, output);
+        }
+        return true;
+    };
+
+    if(small)
+    {
+        auto const done =
+            m_engine == raster_engine::floating_point ?
+            rasterize_small(line_list<small_storage>{m_clip}) :
+            rasterize_small(fixed_edge_list<small_storage>{m_clip});
+        if(done)
+            return;
+    }
+
+    switch(m_engine)
+    {
+        case raster_engine::floating_point:
+        {
+            auto lines = line_list<>{m_clip};
+            if(auto const bounds = decode(lines))
+            {
+                rasterize_scanlines(
+                    bounds->start_x, bounds->end_x,
+                    bounds->start_y, bounds->end_y,
+                    lines, output);
+            }
+            break;
+        }
+        case raster_engine::fixed_point:
+        {
+            auto edges = fixed_edge_list<>{m_clip};
+            if(auto const bounds = decode(edges))
+            {
+                rasterize_scanlines(
+                    bounds->start_x, bounds->end_x,
+                    bounds->start_y, bounds->end_y,
+                    edges, output);
+            }
+            break;
+        }
+        case raster_engine::tiled:
+        {
+            auto edges = fixed_edge_list<>{m_clip};
+            if(auto const bounds = decode(edges))
+            {
+                rasterize_scanlines(
+                    bounds->start_x, bounds->end_x,
+                    bounds->start_y, bounds->end_y,
+                    tiled_edges{std::move(edges.edges)}, output);
+            }
+            break;
+        }
+    }
+}
+
+void rasterizer::implementation::rasterize_bands(
+    shape const & s, float x_offset, float y_offset,
+    std::size_t band_height, band_callback const & callback) const
+{
+    if(band_height == 0 || m_width == 0 || m_height == 0)
+        return;
+
+    auto const bounds = pixel_bounds(s, x_offset, y_offset);
+    if(!bounds)
+    {
+        // Nothing to draw, bands are still produced
+        auto const empty = pixel_rect{0, 0, 0, 0};
+        auto band_lines = line_list<>{m_clip};
+        rasterize_bands(
+            empty, std::vector<line_segment>{}, band_lines, band_height,
+            callback);
+        return;
+    }
+
+    switch(m_engine)
+    {
+        case raster_engine::floating_point:
+        {
+            auto band_lines = line_list<>{m_clip};
+            rasterize_bands(
+                *bounds, create_lines(s, x_offset, y_offset).edges,
+                band_lines, band_height, callback);
+            break;
+        }
+        case raster_engine::fixed_point:
+        {
+            auto band_edges = fixed_edge_list<>{m_clip};
+            rasterize_bands(
+                *bounds, create_fixed_edges(s, x_offset, y_offset).edges,
+                band_edges, band_height, callback);
+            break;
+        }
+        case raster_engine::tiled:
+        {
+            auto band_edges = tiled_edges{};
+            rasterize_bands(
+                *bounds, create_fixed_edges(s, x_offset, y_offset).edges,
+                band_edges, band_height, callback);
+            break;
+        }
+    }
+}
+
+template <typename Edge, typename Edges>
+void rasterizer::implementation::rasterize_bands(
+    pixel_rect const & bounds, std::vector<Edge> edges, Edges & band_edges,
+    std::size_t band_height, band_callback const & callback) const
+{
+    band_height = std::min(band_height, m_height);
+
+    auto band = std::vector<std::uint8_t>(m_width * band_height);
+    auto const stride = static_cast<std::ptrdiff_t>(m_width);
+    auto const band_view =
+        image_view<pixel_format::a8>{band.data(), m_width, band_height, stride};
+    auto const blender =
+        detail::span_blender<pixel_format::a8, blend_mode::replace>{
+            band_view, paint{}};
+
+    // Bands are produced from top to bottom, in the order image files
+    // usually store the rows. Edges join the band list in order of their
+    // top ends, when the first band they cross is reached, and leave it
+    // after the last one, so that each band only goes through the edges
+    // crossing it.
+    std::sort(
+        std::begin(edges), std::end(edges),
+        [](Edge const & a, Edge const & b) { return a.y2 > b.y2; });
+    auto next_edge = std::cbegin(edges);
+    auto & active = band_edges.edges;
+
+    for(auto band_end = m_height; band_end != 0;)
+    {
+        auto const band_start =
+            band_end > band_height ? band_end - band_height : 0;
+        auto const rows = band_end - band_start;
+
+        std::fill(std::begin(band), std::end(band), std::uint8_t{0});
+
+        auto const start_y = std::max(band_start, bounds.start_y);
+        auto const end_y = std::min(band_end, bounds.end_y);
+        auto output = [&blender, band_start](
+            std::size_t y, std::size_t x, std::size_t count,
+            float coverage)
+        {
+            blender(y - band_start, x, count, coverage);
+        };
+
+        if(start_y < end_y)
+        {
+            active.erase(
+                std::remove_if(
+                    std::begin(active), std::end(active),
+                    [start_y, end_y](Edge const & e)
+                    {
+                        return !crosses_rows(e, start_y, end_y);
+                    }),
+                std::end(active));
+
+            // Edges below the band have not reached it yet
+            for(;
+                next_edge != std::cend(edges) &&
+                crosses_rows(*next_edge, start_y, m_height);
+                ++next_edge)
+            {
+                if(crosses_rows(*next_edge, start_y, end_y))
+                {
+                    active.push_back(*next_edge);
+                }
+            }
+
+            // In order of the first scanline crossed, as rasterize_scanlines
+            // expects
+            std::stable_sort(
+                std::begin(active), std::end(active),
+                [](Edge const & a, Edge const & b) { return a.y1 < b.y1; });
+
+            rasterize_scanlines(
+                bounds.start_x, bounds.end_x, start_y, end_y,
+                band_edges, output);
+        }
+
+        callback(band.data(), band_start, rows, stride);
+        band_end = band_start;
+    }
+}
+
+coverage_mask rasterizer::implementation::rasterize_mask(
+    shape const & s, float x_offset, float y_offset) const
+{
+    auto const bounds = pixel_bounds(s, x_offset, y_offset);
+    if(!bounds)
+        return {};
+
+    auto const width = std::min<std::size_t>(
+        bounds->end_x - bounds->start_x, 0xFFFF);
+    auto mask = coverage_mask{
+        bounds->start_x, bounds->start_y,
+        width, bounds->end_y - bounds->start_y};
+
+    auto output = [&mask, width, &bounds](
+        std::size_t y, std::size_t x, std::size_t count, float coverage)
+    {
+        auto const mx = x - bounds->start_x;
+        if(mx >= width)
+            return;
+
+        auto const out = std::min(255, static_cast<int>(coverage * 255.0f));
+        mask.add_span(
+            y - bounds->start_y, mx, std::min(count, width - mx),
+            static_cast<std::uint8_t>(out));
+    };
+    rasterize(s, x_offset, y_offset, output);
+    mask.finish();
+
+    return mask;
+}
+
+void rasterizer::implementation::blit(
+    coverage_mask const & mask,
+    std::ptrdiff_t x_offset, std::ptrdiff_t y_offset,
+    paint const & p) const
+{
+    with_blender(
+        p,
+        [&](auto const & blender)
+        {
+            blit(mask, x_offset, y_offset, blender);
+        });
+}
+
+template <typename Blender>
+void rasterizer::implementation::blit(
+    coverage_mask const & mask,
+    std::ptrdiff_t x_offset, std::ptrdiff_t y_offset,
+    Blender const & blender) const
+{
+    auto const clip_x1 = static_cast<std::ptrdiff_t>(m_clip.start_x);
+    auto const clip_x2 = static_cast<std::ptrdiff_t>(m_clip.end_x);
+    auto const clip_y1 = static_cast<std::ptrdiff_t>(m_clip.start_y);
+    auto const clip_y2 = static_cast<std::ptrdiff_t>(m_clip.end_y);
+    auto const mask_x = static_cast<std::ptrdiff_t>(mask.x()) + x_offset;
+    auto const mask_y = static_cast<std::ptrdiff_t>(mask.y()) + y_offset;
+
+    // Pixels of the target the run [x1, x2) of a mask row maps to, within
+    // the clip rectangle, and the number of mask pixels clipped off from the
+    // left.
+    struct target_run
+    {
+        std::size_t x;
+        std::size_t count;
+        std::size_t skip;
+    };
+
+    auto const clip_run = [&](std::ptrdiff_t x1, std::ptrdiff_t x2)
+    {
+        auto const tx1 = std::max(mask_x + x1, clip_x1);
+        auto const tx2 = std::min(mask_x + x2, clip_x2);
+        if(tx1 >= tx2)
+            return target_run{0, 0, 0};
+
+        return target_run{
+            static_cast<std::size_t>(tx1),
+            static_cast<std::size_t>(tx2 - tx1),
+            static_cast<std::size_t>(tx1 - (mask_x + x1))};
+    };
+
+    for(auto r = std::size_t{0}; r != mask.height(); ++r)
+    {
+        auto const ty = mask_y + static_cast<std::ptrdiff_t>(r);
+        if(ty < clip_y1 || ty >= clip_y2)
+            continue;
+
+        auto const y = static_cast<std::size_t>(ty);
+        auto const row = mask.row(r);
+        auto const * literal = row.literals;
+        auto cx = std::ptrdiff_t{0};
+
+        // Replace clears the pixels between segments, as rasterize does
+        auto const clear_to = [&](std::ptrdiff_t x)
+        {
+            if constexpr(Blender::mode == blend_mode::replace)
+            {
+                auto const run = clip_run(cx, x);
+                if(run.count)
+                {
+                    blender.fill(y, run.x, run.count, 0);
+                }
+            }
+        };
+
+        for(auto const * seg = row.begin; seg != row.end; ++seg)
+        {
+            auto const x1 = static_cast<std::ptrdiff_t>(seg->x);
+            auto const x2 = x1 + static_cast<std::ptrdiff_t>(seg->length);
+            auto const run = clip_run(x1, x2);
+
+            clear_to(x1);
+
+            if(seg->literal)
+            {
+                if(run.count)
+                {
+                    blender.copy(y, run.x, run.count, literal + run.skip);
+                }
+                literal += seg->length;
+            }
+            else if(run.count)
+            {
+                blender.fill(y, run.x, run.count, seg->coverage);
+            }
+
+            cx = x2;
+        }
+
+        clear_to(static_cast<std::ptrdiff_t>(mask.width()));
+    }
+}
+
+std::optional<rasterizer::implementation::pixel_rect>
+rasterizer::implementation::pixel_bounds(
+    shape const & s, float x_offset, float y_offset) const
+{
+    return pixel_bounds(
+        s.min_x() + x_offset, s.min_y() + y_offset,
+        s.max_x() + x_offset, s.max_y() + y_offset);
+}
+
+std::optional<rasterizer::implementation::pixel_rect>
+rasterizer::implementation::pixel_bounds(
+    float min_x, float min_y, float max_x, float max_y) const
+{
+    auto const start_x = std::max(
+        static_cast<float>(m_clip.start_x), std::floor(min_x));
+    auto const start_y = std::max(
+        static_cast<float>(m_clip.start_y), std::floor(min_y));
+    auto const end_x = std::min(
+        static_cast<float>(m_clip.end_x), std::ceil(max_x));
+    auto const end_y = std::min(
+        static_cast<float>(m_clip.end_y), std::ceil(max_y));
+
+    // Shape is out of bounds
+    if(start_x >= end_x || start_y >= end_y)
+        return std::nullopt;
+
+    return pixel_rect{
+        static_cast<std::size_t>(start_x), static_cast<std::size_t>(end_x),
+        static_cast<std::size_t>(start_y), static_cast<std::size_t>(end_y)};
+}
+
+std::optional<rasterizer::implementation::pixel_rect>
+rasterizer::implementation::transformed_bounds(
+    float min_x, float min_y, float max_x, float max_y,
+    transform const & t) const
+{
+    auto const p1 = t.apply(min_x, min_y);
+    auto const p2 = t.apply(max_x, min_y);
+    auto const p3 = t.apply(min_x, max_y);
+    auto const p4 = t.apply(max_x, max_y);
+
+    return pixel_bounds(
+        std::min({p1.x, p2.x, p3.x, p4.x}), std::min({p1.y, p2.y, p3.y, p4.y}),
+        std::max({p1.x, p2.x, p3.x, p4.x}), std::max({p1.y, p2.y, p3.y, p4.y}));
+}
+
+std::size_t rasterizer::implementation::edge_count(shape const & s)
+{
+    auto count = std::size_t{0};
+    for(auto const & c: s)
+    {
+        count += c.size();
+    }
+
+    return count;
+}
+
+template <typename Edges>
+void rasterizer::implementation::add_edges(
+    Edges & edges, shape const & s, float x_offset, float y_offset)
+{
+    for(auto const & contour: s)
+    {
+        if(contour.empty())
+            continue;
+
+        auto const add_edge = [&](auto const & v1, auto const & v2)
+        {
+            edges.add(
+                v1.x+x_offset, v1.y+y_offset,
+                v2.x+x_offset, v2.y+y_offset);
+        };
+
+        for(auto i = std::size_t{1}; i != contour.size(); ++i)
+        {
+            add_edge(contour[i-1], contour[i]);
+        }
+        add_edge(contour.back(), contour.front());
+    }
+}
+
+rasterizer::implementation::line_list<>
+rasterizer::implementation::create_lines(
+    shape const & s,
+    float x_offset, float y_offset) const
+{
+    auto lines = line_list<>{m_clip};
+    lines.edges.reserve(edge_count(s));
+    add_edges(lines, s, x_offset, y_offset);
+    lines.finish();
+
+    return lines;
+}
+
+/* Class: rasterizer::implementation::line_list */
+template <typename Storage>
+rasterizer::implementation::line_list<Storage>::line_list(
+    pixel_rect const & clip):
+    m_clip_x2{static_cast<float>(clip.end_x)},
+    m_clip_y1{static_cast<float>(clip.start_y)},
+    m_clip_y2{static_cast<float>(clip.end_y)}
+{}
+
+template <typename Storage>
+void rasterizer::implementation::line_list<Storage>::add(
+    float x1, float y1, float x2, float y2)
+{
+    // Ignore horizontal lines
+    if(y1 == y2)
+        return;
+
+    auto l = line_segment{x1, y1, x2, y2, -1};
+    if(l.y1 > l.y2)
+    {
+        std::swap(l.x1, l.x2);
+        std::swap(l.y1, l.y2);
+        l.winding = 1;
+    }
+
+    // Lines above, below or right of the clip rectangle do not affect any
+    // pixel inside it. Lines left of it still do.
+    if(l.y2 <= m_clip_y1 || l.y1 >= m_clip_y2 ||
+        std::min(l.x1, l.x2) >= m_clip_x2)
+    {
+        return;
+    }
+
+    edges.push_back(l);
+}
+
+template <typename Storage>
+void rasterizer::implementation::line_list<Storage>::finish()
+{
+    // Sort lines by the first scanline they cross
+    auto const first_row = [clip_y1=m_clip_y1](line_segment const & l)
+    {
+        return static_cast<std::size_t>(std::max(l.y1, clip_y1));
+    };
+    sort_by_key(edges, first_row);
+}
+
+template <typename Storage, typename Output>
+void rasterizer::implementation::rasterize_scanlines(
+        std::size_t const start_x, std::size_t const end_x,
+        std::size_t const start_y, std::size_t const end_y,
+        line_list<Storage> const & list,
+        Output & output) const
+{
+    auto const & lines = list.edges;
+
+    // Lines crossing the current scanline, clipped to it. Kept in order of
+    // x2 from one scanline to the next, so that sorting has little to do.
+    typename Storage::template vector<active_line> scanline_buffer;
+    auto line_it = std::cbegin(lines);
+
+    // Kernels for long runs of crossed pixels, and their buffers
+    auto const resolve = detail::resolve_scanline_kernel();
+    auto const to_8bit = detail::coverage_to_8bit_kernel();
+    auto const even_odd = m_fill_rule == fill_rule::even_odd;
+    auto const width = end_x - start_x;
+    typename Storage::template vector<detail::scanline_edge> run_edges;
+    typename Storage::template vector<float> run_coverage(width);
+    typename Storage::template vector<std::uint8_t> run_coverage_8bit(
+        copies_8bit_coverage<std::remove_cv_t<Output>> ? width : 0);
+
+    for(auto cy = start_y; cy < end_y; ++cy)
+    {
+        auto const fcy = static_cast<float>(cy);
+
+        auto const ended = [fcy](auto const & a)
+        {
+            return a.line->y2 <= fcy;
+        };
+        scanline_buffer.erase(
+            std::remove_if(
+                std::begin(scanline_buffer), std::end(scanline_buffer), ended),
+            std::end(scanline_buffer));
+
+        for(; line_it != std::cend(lines) && line_it->y1 < fcy+1.0f; ++line_it)
+        {
+            if(line_it->y2 > fcy)
+            {
+                scanline_buffer.push_back({&*line_it, {}});
+            }
+        }
+
+        for(auto & a: scanline_buffer)
+        {
+            a.edge = clip(fcy, *a.line);
+        }
+
+        // Insertion sort by x2
+        for(auto i = std::begin(scanline_buffer); i != std::end(scanline_buffer); ++i)
+        {
+            auto const a = *i;
+            auto j = i;
+            for(; j != std::begin(scanline_buffer) && a.edge.x2 < (j-1)->edge.x2; --j)
+            {
+                *j = *(j-1);
+            }
+            *j = a;
+        }
+
+        auto coverage1 = 0.0f;
+        auto sbuf_it = std::cbegin(scanline_buffer);
+
+        for(auto cx = start_x; cx < end_x;)
+        {
+            auto const fcx = static_cast<float>(cx);
+
+            while(
+                sbuf_it != std::cend(scanline_buffer) &&
+                sbuf_it->edge.x2 < fcx)
+            {
+                coverage1 += sbuf_it->edge.coverage(fcx);
+                ++sbuf_it;
+            }
+
+            // Pixels up to the right end of the edges crossing pixel cx are
+            // all crossed by an edge, and resolved at once if there are
+            // min_kernel_run of them
+            auto coverage2 = 0.0f;
+            auto crossed_x2 = -1.0f;
+            auto next_x1 = static_cast<float>(end_x);
+            for(auto it = sbuf_it; it != std::cend(scanline_buffer); ++it)
+            {
+                if((fcx+1.0f) >= it->edge.x1)
+                {
+                    coverage2 += it->edge.coverage(fcx);
+                    crossed_x2 = std::max(crossed_x2, it->edge.x2);
+                    next_x1 = fcx+1.0f;
+                }
+                else
+                {
+                    next_x1 = std::min(next_x1, it->edge.x1);
+                }
+            }
+
+            auto const run_end = static_cast<std::size_t>(std::min(
+                std::floor(crossed_x2) + 1.0f, static_cast<float>(end_x)));
+            if(run_end >= cx + min_kernel_run)
+            {
+                // Edges starting right of the run add nothing to it
+                auto const frun_end = static_cast<float>(run_end);
+                run_edges.clear();
+                for(auto it = sbuf_it; it != std::cend(scanline_buffer); ++it)
+                {
+                    if(it->edge.x1 <= frun_end)
+                    {
+                        run_edges.push_back(
+                            {it->edge.x1, it->edge.x2, it->edge.winding_height});
+                    }
+                }
+
+                auto const count = run_end - cx;
+                resolve(
+                    run_edges.data(), run_edges.size(), cx, count, coverage1,
+                    even_odd, run_coverage.data());
+
+                if constexpr(copies_8bit_coverage<std::remove_cv_t<Output>>)
+                {
+                    to_8bit(run_coverage.data(), run_coverage_8bit.data(), count);
+                    output.copy(cy, cx, count, run_coverage_8bit.data());
+                }
+                else
+                {
+                    // Pixels of equal coverage as single spans
+                    for(auto i = std::size_t{0}; i != count;)
+                    {
+                        auto j = i+1;
+                        while(j != count && run_coverage[j] == run_coverage[i])
+                        {
+                            ++j;
+                        }
+
+                        output(cy, cx+i, j-i, run_coverage[i]);
+                        i = j;
+                    }
+                }
+
+                cx = run_end;
+                continue;
+            }
+
+            next_x1 = std::floor(next_x1);
+            WTTF_ASSERT(next_x1 > fcx);
+
+            auto const next_cx = static_cast<std::size_t>(next_x1);
+            auto const out_count = next_cx - cx;
+
+            auto const coverage = coverage1 + coverage2;
+            auto const w = resolve_coverage(coverage, m_fill_rule);
+            output(cy, cx, out_count, w);
+
+            cx = next_cx;
+        }
+    }
+}
+
+std::int32_t rasterizer::implementation::fixed_edge::x_at(
+    std::int32_t y) const
+{
+    if(y >= y2)
+        return x2;
+
+    auto const x = x1 + static_cast<std::int32_t>(
+        (static_cast<std::int64_t>(y - y1) * dxdy) >> 16);
+    return std::clamp(x, std::min(x1, x2), std::max(x1, x2));
+}
+
+std::int32_t rasterizer::implementation::fixed_edge::y_at(
+    std::int32_t x) const
+{
+    auto const y = y1 + static_cast<std::int32_t>(
+        (static_cast<std::int64_t>(x - x1) * dydx) >> 16);
+    return std::clamp(y, y1, y2);
+}
+
+rasterizer::implementation::fixed_edge_list<>
+rasterizer::implementation::create_fixed_edges(
+    shape const & s,
+    float x_offset, float y_offset) const
+{
+    auto edges = fixed_edge_list<>{m_clip};
+    edges.edges.reserve(edge_count(s));
+    add_edges(edges, s, x_offset, y_offset);
+    edges.finish();
+
+    return edges;
+}
+
+/* Class: rasterizer::implementation::fixed_edge_list */
+template <typename Storage>
+rasterizer::implementation::fixed_edge_list<Storage>::fixed_edge_list(
+    pixel_rect const & clip):
+    m_clip_x2{static_cast<std::int32_t>(clip.end_x) * fixed_one},
+    m_clip_y1{static_cast<std::int32_t>(clip.start_y) * fixed_one},
+    m_clip_y2{static_cast<std::int32_t>(clip.end_y) * fixed_one}
+{}
+
+template <typename Storage>
+void rasterizer::implementation::fixed_edge_list<Storage>::add(
+    float x1, float y1, float x2, float y2)
+{
+    auto const to_fixed = [](float v)
+    {
+        return static_cast<std::int32_t>(
+            std::lround(v * static_cast<float>(fixed_one)));
+    };
+
+    auto e = fixed_edge{
+        to_fixed(x1), to_fixed(y1),
+        to_fixed(x2), to_fixed(y2),
+        0, 0, 1};
+
+    // Ignore horizontal lines
+    if(e.y1 == e.y2)
+        return;
+
+    if(e.y1 > e.y2)
+    {
+        std::swap(e.x1, e.x2);
+        std::swap(e.y1, e.y2);
+        e.winding = -1;
+    }
+
+    // See line_list::add
+    if(e.y2 <= m_clip_y1 || e.y1 >= m_clip_y2 ||
+        std::min(e.x1, e.x2) >= m_clip_x2)
+    {
+        return;
+    }
+
+    auto const dx = static_cast<std::int64_t>(e.x2 - e.x1);
+    auto const dy = static_cast<std::int64_t>(e.y2 - e.y1);
+    e.dxdy = dx * 65536 / dy;
+    e.dydx = dx != 0 ? dy * 65536 / dx : 0;
+    edges.push_back(e);
+}
+
+template <typename Storage>
+void rasterizer::implementation::fixed_edge_list<Storage>::finish()
+{
+    // Sort edges by the first row they cross
+    auto const first_row = [clip_y1=m_clip_y1](fixed_edge const & e)
+    {
+        return static_cast<std::size_t>(std::max(e.y1, clip_y1) >> fixed_shift);
+    };
+    sort_by_key(edges, first_row);
+}
+
+template <typename Storage, typename Output>
+void rasterizer::implementation::rasterize_scanlines(
+        std::size_t const start_x, std::size_t const end_x,
+        std::size_t const start_y, std::size_t const end_y,
+        fixed_edge_list<Storage> const & list,
+        Output & output) const
+{
+    using buffer = typename Storage::template vector<std::int32_t>;
+    auto const & edges = list.edges;
+
+    // Accumulation buffer has one extra cell for the right edge of the
+    // last pixel.
+    auto acc = buffer(end_x - start_x + 1);
+    auto values = buffer(end_x - start_x);
+    auto const resolve = detail::resolve_area_kernel();
+    auto const even_odd = m_fill_rule == wttf::fill_rule::even_odd;
+    typename Storage::template vector<fixed_edge const *> active;
+    auto edge_it = std::cbegin(edges);
+
+    for(auto cy = start_y; cy < end_y; ++cy)
+    {
+        auto const row = static_cast<std::int32_t>(cy);
+        auto const row_top = (row + 1) * fixed_one;
+
+        auto const ended = [row_bottom=row*fixed_one](auto const * e)
+        {
+            return e->y2 <= row_bottom;
+        };
+        active.erase(
+            std::remove_if(std::begin(active), std::end(active), ended),
+            std::end(active));
+
+        for(; edge_it != std::cend(edges) && edge_it->y1 < row_top; ++edge_it)
+        {
+            if(!ended(&*edge_it))
+            {
+                active.push_back(&*edge_it);
+            }
+        }
+
+        if(active.empty())
+        {
+            output(cy, start_x, end_x - start_x, 0.0f);
+            continue;
+        }
+
+        for(auto const * e: active)
+        {
+            accumulate_fixed(*e, row, start_x, acc.data(), acc.size());
+        }
+
+        // Resolve: running sum of accumulated area is the coverage of the
+        // pixel. This also clears the accumulation buffer for the next row.
+        resolve(
+            acc.data(), values.data(), values.size(), 0,
+            fixed_full_area, even_odd);
+        acc.back() = 0;
+
+        // Runs of equal coverage are output as one span
+        auto run_start = start_x;
+        auto run_value = std::int32_t{0};
+        for(auto cx = start_x; cx < end_x; ++cx)
+        {
+            auto const value = values[cx - start_x];
+
+            if(value != run_value)
+            {
+                if(cx != run_start)
+                {
+                    output(
+                        cy, run_start, cx - run_start,
+                        static_cast<float>(run_value) /
+                        static_cast<float>(fixed_full_area));
+                }
+                run_start = cx;
+                run_value = value;
+            }
+        }
+
+        output(
+            cy, run_start, end_x - run_start,
+            static_cast<float>(run_value) /
+            static_cast<float>(fixed_full_area));
+    }
+}
+
+void rasterizer::implementation::accumulate_fixed(
+    fixed_edge const & e, std::int32_t row, std::size_t start_x,
+    std::int32_t * acc, std::size_t acc_size)
+{
+    auto const left = static_cast<std::int32_t>(start_x);
+    auto const right = left + static_cast<std::int32_t>(acc_size) - 1;
+
+    // Adds segment, within a single pixel, with height dy and with sum of
+    // x coordinates (relative to pixel) at its ends fx_sum.
+    auto const add_cell = [&](std::int32_t cx, std::int32_t dy, std::int32_t fx_sum)
+    {
+        auto const cover = 2 * fixed_one * dy * e.winding;
+        if(cx < left)
+        {
+            acc[0] += cover;
+        }
+        else if(cx < right)
+        {
+            auto const i = static_cast<std::size_t>(cx - left);
+            auto const area = dy * (2*fixed_one - fx_sum) * e.winding;
+            acc[i] += area;
+            acc[i+1] += cover - area;
+        }
+    };
+
+    auto const ya = std::max(e.y1, row * fixed_one);
+    auto const yb = std::min(e.y2, (row + 1) * fixed_one);
+    auto const xa = e.x_at(ya);
+    auto const xb = e.x_at(yb);
+
+    auto cx = xa >> fixed_shift;
+    auto const cx_end = xb >> fixed_shift;
+    auto const step = cx_end > cx ? 1 : -1;
+    auto x = xa;
+    auto y = ya;
+
+    while(cx != cx_end)
+    {
+        auto const boundary = (step > 0 ? cx + 1 : cx) * fixed_one;
+        auto const next_y = std::clamp(e.y_at(boundary), y, yb);
+        auto const cell_x = cx * fixed_one;
+        add_cell(cx, next_y - y, (x - cell_x) + (boundary - cell_x));
+        x = boundary;
+        y = next_y;
+        cx += step;
+    }
+
+    auto const cell_x = cx * fixed_one;
+    add_cell(cx, yb - y, (x - cell_x) + (xb - cell_x));
+}
+
+bool rasterizer::implementation::crosses_rows(
+    line_segment const & l, std::size_t start_y, std::size_t end_y)
+{
+    return
+        l.y1 < static_cast<float>(end_y) && l.y2 > static_cast<float>(start_y);
+}
+
+bool rasterizer::implementation::crosses_rows(
+    fixed_edge const & e, std::size_t start_y, std::size_t end_y)
+{
+    return
+        e.y1 < static_cast<std::int32_t>(end_y) * fixed_one &&
+        e.y2 > static_cast<std::int32_t>(start_y) * fixed_one;
+}
+
+template <typename Output>
+void rasterizer::implementation::rasterize_scanlines(
+        std::size_t const start_x, std::size_t const end_x,
+        std::size_t const start_y, std::size_t const end_y,
+        tiled_edges const & tiled,
+        Output & output) const
+{
+    auto const & edges = tiled.edges;
+    auto const width = end_x - start_x;
+    auto const num_bands = (end_y - start_y + tile_size - 1) / tile_size;
+    auto const num_columns = (width + tile_size - 1) / tile_size;
+
+    // Bands of tile rows an edge passes through, [first, last)
+    auto const band_range = [&](fixed_edge const & e)
+    {
+        auto const first_row = static_cast<std::ptrdiff_t>(
+            std::max<std::int32_t>(e.y1 >> fixed_shift, 0));
+        auto const last_row = static_cast<std::ptrdiff_t>(
+            std::max<std::int32_t>((e.y2 - 1) >> fixed_shift, -1));
+        auto const r1 = std::max(first_row, static_cast<std::ptrdiff_t>(start_y));
+        auto const r2 = std::min(last_row, static_cast<std::ptrdiff_t>(end_y) - 1);
+
+        if(r1 > r2)
+            return std::make_pair(std::size_t{0}, std::size_t{0});
+
+        return std::make_pair(
+            (static_cast<std::size_t>(r1) - start_y) / tile_size,
+            (static_cast<std::size_t>(r2) - start_y) / tile_size + 1);
+    };
+
+    // Bin edges into bands, as lists of edge indices
+    auto band_offsets = std::vector<std::size_t>(num_bands + 1);
+    for(auto const & e: edges)
+    {
+        auto const [b1, b2] = band_range(e);
+        for(auto b = b1; b != b2; ++b)
+        {
+            ++band_offsets[b+1];
+        }
+    }
+
+    for(auto b = std::size_t{0}; b != num_bands; ++b)
+    {
+        band_offsets[b+1] += band_offsets[b];
+    }
+
+    auto band_edges = std::vector<std::size_t>(band_offsets.back());
+    {
+        auto insert_pos = band_offsets;
+        for(auto i = std::size_t{0}; i != edges.size(); ++i)
+        {
+            auto const [b1, b2] = band_range(edges[i]);
+            for(auto b = b1; b != b2; ++b)
+            {
+                band_edges[insert_pos[b]++] = i;
+            }
+        }
+    }
+
+    auto acc = std::vector<std::int32_t>(width + 1);
+    auto values = std::vector<std::int32_t>(width);
+    auto const resolve = detail::resolve_area_kernel();
+    auto const even_odd = m_fill_rule == wttf::fill_rule::even_odd;
+    auto dirty = std::vector<bool>(num_columns);
+    auto dirty_columns = std::vector<std::size_t>{};
+    dirty_columns.reserve(num_columns);
+
+    // Tile column of a fixed-point x coordinate
+    auto const column = [&](std::int32_t x)
+    {
+        auto const px = std::clamp<std::int64_t>(
+            x >> fixed_shift,
+            static_cast<std::int64_t>(start_x),
+            static_cast<std::int64_t>(end_x) - 1);
+        return (static_cast<std::size_t>(px) - start_x) / tile_size;
+    };
+
+    for(auto band = std::size_t{0}; band != num_bands; ++band)
+    {
+        auto const band_start = start_y + band * tile_size;
+        auto const band_end = std::min(band_start + tile_size, end_y);
+        auto const first_edge = std::cbegin(band_edges) +
+            static_cast<std::ptrdiff_t>(band_offsets[band]);
+        auto const last_edge = std::cbegin(band_edges) +
+            static_cast<std::ptrdiff_t>(band_offsets[band+1]);
+
+        // Spans of no coverage are left out. If the output would clear the
+        // pixels under them, the whole band is cleared at once instead.
+        if constexpr(writes_empty_spans<std::remove_cv_t<Output>>)
+        {
+            output.clear(band_start, band_end, start_x, width);
+        }
+
+        // No edges in the whole band: every pixel is outside
+        if(first_edge == last_edge)
+            continue;
+
+        // Mark tiles the edges of this band pass through
+        std::fill(std::begin(dirty), std::end(dirty), false);
+        auto const band_y1 = static_cast<std::int32_t>(band_start) * fixed_one;
+        auto const band_y2 = static_cast<std::int32_t>(band_end) * fixed_one;
+        for(auto it = first_edge; it != last_edge; ++it)
+        {
+            auto const & e = edges[*it];
+            auto const xa = e.x_at(std::max(e.y1, band_y1));
+            auto const xb = e.x_at(std::min(e.y2, band_y2));
+            auto const c2 = column(std::max(xa, xb));
+            for(auto c = column(std::min(xa, xb)); c <= c2; ++c)
+            {
+                dirty[c] = true;
+            }
+        }
+
+        dirty_columns.clear();
+        for(auto c = std::size_t{0}; c != num_columns; ++c)
+        {
+            if(dirty[c])
+            {
+                dirty_columns.push_back(c);
+            }
+        }
+
+        for(auto cy = band_start; cy != band_end; ++cy)
+        {
+            auto const row = static_cast<std::int32_t>(cy);
+            auto const row_bottom = row * fixed_one;
+            auto const row_top = row_bottom + fixed_one;
+
+            for(auto it = first_edge; it != last_edge; ++it)
+            {
+                auto const & e = edges[*it];
+                if(e.y1 < row_top && e.y2 > row_bottom)
+                {
+                    accumulate_fixed(e, row, start_x, acc.data(), acc.size());
+                }
+            }
+
+            // Resolve, as in the fixed-point engine, but skip over clean
+            // tiles. In a clean tile only the first pixel can have
+            // accumulated area, left there by an edge in the previous tile.
+            auto sum = std::int32_t{0};
+            auto run_start = start_x;
+            auto run_value = std::int32_t{0};
+
+            auto const output_run = [&](std::size_t x)
+            {
+                if(run_value != 0 && x != run_start)
+                {
+                    output(
+                        cy, run_start, x - run_start,
+                        static_cast<float>(run_value) /
+                        static_cast<float>(fixed_full_area));
+                }
+            };
+
+            auto const push = [&](std::size_t x, std::int32_t value)
+            {
+                if(value != run_value)
+                {
+                    output_run(x);
+                    run_start = x;
+                    run_value = value;
+                }
+            };
+
+            auto const resolve_run = [&](std::size_t x1, std::size_t x2)
+            {
+                auto const i = x1 - start_x;
+                sum = resolve(
+                    acc.data() + i, values.data() + i, x2 - x1, sum,
+                    fixed_full_area, even_odd);
+
+                for(auto x = x1; x != x2; ++x)
+                {
+                    push(x, values[x - start_x]);
+                }
+            };
+
+            auto cx = start_x;
+            for(auto c = std::cbegin(dirty_columns); c != std::cend(dirty_columns);)
+            {
+                // Adjacent dirty tiles are resolved together
+                auto last = c;
+                while(
+                    std::next(last) != std::cend(dirty_columns) &&
+                    *std::next(last) == *last + 1)
+                {
+                    ++last;
+                }
+
+                auto const tile_x1 = start_x + *c * tile_size;
+                auto const tile_x2 =
+                    std::min(start_x + (*last + 1) * tile_size, end_x);
+
+                if(cx < tile_x1)
+                {
+                    resolve_run(cx, cx+1);
+                }
+
+                resolve_run(tile_x1, tile_x2);
+                cx = tile_x2;
+                c = std::next(last);
+            }
+
+            if(cx < end_x)
+            {
+                resolve_run(cx, cx+1);
+            }
+
+            acc[width] = 0;
+            output_run(end_x);
+        }
+    }
+}
+
+rasterizer::implementation::edge_info
+rasterizer::implementation::clip(float const y1, line_segment seg) const
+{
+    auto const y2 = y1+1.0f;
+    WTTF_ASSERT(seg.y2 > y1 && seg.y1 < y2);
+
+    auto const dy = seg.y2 - seg.y1;
+    auto const fdx = (seg.x2 - seg.x1)/dy;
+
+    if(seg.y1 < y1)
+    {
+        seg.x1 += fdx * (y1 - seg.y1);
+        seg.y1 = y1;
+    }
+
+    if(seg.y2 > y2)
+    {
+        seg.x2 += fdx * (y2 - seg.y2);
+        seg.y2 = y2;
+    }
+
+    auto const x1 = std::min(seg.x1, seg.x2);
+    auto const x2 = std::max(seg.x1, seg.x2);
+    auto const h = (seg.y2 - seg.y1) * static_cast<float>(seg.winding);
+
+    return {x1, x2, h};
+}
+
+clip_rect rasterizer::implementation::clip() const
+{
+    return {
+        m_clip.start_x, m_clip.start_y,
+        m_clip.end_x - m_clip.start_x, m_clip.end_y - m_clip.start_y};
+}
+
+void rasterizer::implementation::set_clip(clip_rect const & r)
+{
+    auto const start_x = std::min(r.x, m_width);
+    auto const start_y = std::min(r.y, m_height);
+    m_clip = {
+        start_x, start_x + std::min(r.width, m_width - start_x),
+        start_y, start_y + std::min(r.height, m_height - start_y)};
+}
+
+/* Class: rasterizer */
+rasterizer::rasterizer() = default;
+rasterizer::rasterizer(rasterizer &&) = default;
+
+rasterizer::rasterizer(
+    std::uint8_t * image,
+    std::size_t width,
+    std::size_t height,
+    std::ptrdiff_t stride):
+    rasterizer{image_view<pixel_format::a8>{image, width, height, stride}}
+{}
+
+rasterizer::rasterizer(image_view<pixel_format::a8> const & target):
+    m_impl{std::make_unique<implementation>(target)}
+{}
+
+rasterizer::rasterizer(image_view<pixel_format::rgba8> const & target):
+    m_impl{std::make_unique<implementation>(target)}
+{}
+
+rasterizer::rasterizer(image_view<pixel_format::bgra8> const & target):
+    m_impl{std::make_unique<implementation>(target)}
+{}
+
+rasterizer::rasterizer(
+    image_view<pixel_format::float_coverage> const & target):
+    m_impl{std::make_unique<implementation>(target)}
+{}
+
+rasterizer::rasterizer(std::size_t width, std::size_t height):
+    m_impl{std::make_unique<implementation>(width, height)}
+{}
+
+rasterizer::~rasterizer() = default;
+
+rasterizer & rasterizer::operator=(rasterizer &&) = default;
+
+void rasterizer::rasterize(
+    shape const & s, float x_offset, float y_offset, paint const & p) const
+{
+    if(!m_impl)
+        return;
+
+    if(!s.flat())
+    {
+        rasterize(s.flatten(flatness), x_offset, y_offset, p);
+        return;
+    }
+
+    m_impl->rasterize(s, x_offset, y_offset, p);
+}
+
+void rasterizer::rasterize(
+    shape const & s, float x_offset, float y_offset, span_sink & sink) const
+{
+    if(!m_impl)
+        return;
+
+    if(!s.flat())
+    {
+        rasterize(s.flatten(flatness), x_offset, y_offset, sink);
+        return;
+    }
+
+    m_impl->rasterize(s, x_offset, y_offset, sink);
+}
+
+void rasterizer::rasterize(
+    shape const & s, transform const & t, paint const & p) const
+{
+    if(m_impl)
+    {
+        m_impl->rasterize(s, t, p);
+    }
+}
+
+void rasterizer::rasterize(
+    shape const & s, transform const & t, span_sink & sink) const
+{
+    if(m_impl)
+    {
+        m_impl->rasterize(s, t, sink);
+    }
+}
+
+void rasterizer::rasterize(
+    outline_view const & o, transform const & t, paint const & p) const
+{
+    if(m_impl)
+    {
+        m_impl->rasterize(o, t, p);
+    }
+}
+
+void rasterizer::rasterize(
+    outline_view const & o, transform const & t, span_sink & sink) const
+{
+    if(m_impl)
+    {
+        m_impl->rasterize(o, t, sink);
+    }
+}
+
+void rasterizer::rasterize_bands(
+    shape const & s, float x_offset, float y_offset,
+    std::size_t band_height, band_callback const & callback) const
+{
+    if(!m_impl)
+        return;
+
+    if(!s.flat())
+    {
+        rasterize_bands(
+            s.flatten(flatness), x_offset, y_offset, band_height, callback);
+        return;
+    }
+
+    m_impl->rasterize_bands(s, x_offset, y_offset, band_height, callback);
+}
+
+void rasterizer::rasterize_glyph(
+    typeface const & face, std::uint16_t glyph_index,
+    transform const & t, paint const & p) const
+{
+    if(!m_impl || !face)
+        return;
+
+    m_impl->rasterize_glyph(*face.m_impl, glyph_index, t, p);
+}
+
+coverage_mask rasterizer::rasterize_mask(
+    shape const & s, float x_offset, float y_offset) const
+{
+    if(!m_impl)
+        return {};
+
+    if(!s.flat())
+    {
+        return rasterize_mask(s.flatten(flatness), x_offset, y_offset);
+    }
+
+    return m_impl->rasterize_mask(s, x_offset, y_offset);
+}
+
+void rasterizer::blit(
+    coverage_mask const & mask,
+    std::ptrdiff_t x_offset, std::ptrdiff_t y_offset,
+    paint const & p) const
+{
+    if(m_impl)
+    {
+        m_impl->blit(mask, x_offset, y_offset, p);
+    }
+}
+
+raster_engine rasterizer::engine() const
+{
+    return m_impl ? m_impl->engine() : raster_engine::floating_point;
+}
+
+void rasterizer::set_engine(raster_engine e)
+{
+    if(m_impl)
+    {
+        m_impl->set_engine(e);
+    }
+}
+
+fill_rule rasterizer::fill_rule() const
+{
+    return m_impl ? m_impl->fill_rule() : fill_rule::non_zero;
+}
+
+void rasterizer::set_fill_rule(wttf::fill_rule r)
+{
+    if(m_impl)
+    {
+        m_impl->set_fill_rule(r);
+    }
+}
+
+clip_rect rasterizer::clip() const
+{
+    return m_impl ? m_impl->clip() : clip_rect{};
+}
+
+void rasterizer::set_clip(clip_rect const & r)
+{
+    if(m_impl)
+    {
+        m_impl->set_clip(r);
+    }
+}
+
+void rasterizer::reset_clip()
+{
+    if(m_impl)
+    {
+        m_impl->set_clip({0, 0, m_impl->width(), m_impl->height()});
+    }
+}
+
+/* Class: span_sink */
+span_sink::~span_sink() = default;
 
 } /* namespace wttf */
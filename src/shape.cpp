@@ -1,9 +1,127 @@
 #include <wttf/assert.hpp>
 #include <wttf/shape.hpp>
+#include "simd.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
 
 namespace wttf
 {
 
+namespace
+{
+
+struct bounding_box
+{
+    float min_x{std::numeric_limits<float>::max()};
+    float min_y{std::numeric_limits<float>::max()};
+    float max_x{std::numeric_limits<float>::lowest()};
+    float max_y{std::numeric_limits<float>::lowest()};
+
+    [[nodiscard]] bool empty() const { return min_x > max_x; }
+
+    void add(float x, float y)
+    {
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+    }
+};
+
+/*
+ * Extends box to cover count vertices. With SSE2, x and y of two vertices
+ * are taken at once, in four independent lanes, which are combined at the
+ * end.
+ */
+void extend_box(
+    shape::vertex const * v, std::size_t count, bounding_box & box)
+{
+    auto i = std::size_t{0};
+
+#if WTTF_HAVE_SSE2
+    if(count >= 2)
+    {
+        // x and y of a vertex, as one 64-bit value
+        auto const xy = [v](std::size_t n)
+        {
+            return static_cast<__m64 const *>(
+                static_cast<void const *>(&v[n].x));
+        };
+
+        auto lo = _mm_setr_ps(box.min_x, box.min_y, box.min_x, box.min_y);
+        auto hi = _mm_setr_ps(box.max_x, box.max_y, box.max_x, box.max_y);
+        for(; i + 2 <= count; i += 2)
+        {
+            auto const p =
+                _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), xy(i)), xy(i + 1));
+
+            // Operand order as in std::min and std::max
+            lo = _mm_min_ps(p, lo);
+            hi = _mm_max_ps(p, hi);
+        }
+
+        lo = _mm_min_ps(_mm_movehl_ps(lo, lo), lo);
+        hi = _mm_max_ps(_mm_movehl_ps(hi, hi), hi);
+        box.min_x = _mm_cvtss_f32(lo);
+        box.min_y = _mm_cvtss_f32(_mm_shuffle_ps(lo, lo, 1));
+        box.max_x = _mm_cvtss_f32(hi);
+        box.max_y = _mm_cvtss_f32(_mm_shuffle_ps(hi, hi, 1));
+    }
+#endif
+
+    for(; i != count; ++i)
+    {
+        box.add(v[i].x, v[i].y);
+    }
+}
+
+/*
+ * Transforms count vertices from src into dst, which may be the same array,
+ * and extends box to cover them. Same math as transform::apply, in a plain
+ * loop over contiguous memory, so that the compiler can vectorize it. The
+ * box is collected in a second pass over dst, as a min/max reduction in the
+ * same loop keeps the compiler from vectorizing it.
+ */
+void transform_vertices(
+    shape::vertex const * src, shape::vertex * dst, std::size_t count,
+    transform const & t, bounding_box & box)
+{
+    auto const [a, b, c, d, tx, ty] = t.matrix;
+
+    for(auto i = std::size_t{0}; i != count; ++i)
+    {
+        auto const x = src[i].x;
+        auto const y = src[i].y;
+        dst[i].x = a*x + c*y + tx;
+        dst[i].y = b*x + d*y + ty;
+        dst[i].on_curve = src[i].on_curve;
+    }
+
+    extend_box(dst, count, box);
+}
+
+/*
+ * Box covering the rectangle transformed by t. Used for shapes without
+ * vertices, which still have bounds.
+ */
+bounding_box transformed_box(
+    float min_x, float min_y, float max_x, float max_y, transform const & t)
+{
+    auto box = bounding_box{};
+    for(auto const & p: {
+        t.apply(min_x, min_y), t.apply(max_x, min_y),
+        t.apply(min_x, max_y), t.apply(max_x, max_y)})
+    {
+        box.add(p.x, p.y);
+    }
+
+    return box;
+}
+
+} /* namespace */
+
 shape::shape(
     float min_x, float min_y, float max_x, float max_y, std::size_t contours):
     m_contours{},
@@ -42,26 +160,37 @@ void shape::add_vertex(float x, float y, bool on_curve)
 
 void shape::add_shape(shape const & s, wttf::transform const & t)
 {
-    auto const min_p = t.apply(s.m_min_x, s.m_min_y);
-    auto const max_p = t.apply(s.m_max_x, s.m_max_y);
-    m_min_x = m_uninitialzed ? min_p.x : std::min(min_p.x, m_min_x);
-    m_min_y = m_uninitialzed ? min_p.y : std::min(min_p.y, m_min_y);
-    m_max_x = m_uninitialzed ? max_p.x : std::max(max_p.x, m_max_x);
-    m_max_y = m_uninitialzed ? max_p.y : std::max(max_p.y, m_max_y);
+    auto const uninitialized = m_uninitialzed;
 
-    m_contours.reserve(m_contours.size() + s.num_contours());
+    // Reserving the exact size would reallocate on every call, when many
+    // shapes are added one by one
+    auto const size = m_contours.size() + s.num_contours();
+    if(size > m_contours.capacity())
+    {
+        m_contours.reserve(std::max(size, 2 * m_contours.capacity()));
+    }
 
-    for(auto i=0u; i<s.num_contours(); ++i)
+    // Bounds of the transformed vertices are correct for any transform,
+    // unlike transformed corners of the old bounds
+    auto box = bounding_box{};
+    for(auto const & cont: s.m_contours)
     {
-        auto const & cont = s.contour(i);
-        add_contour(cont.size());
+        add_contour();
+        auto & result = m_contours.back();
+        result.resize(cont.size());
+        transform_vertices(cont.data(), result.data(), cont.size(), t, box);
+    }
 
-        for(auto const & v1: cont)
-        {
-            auto const & v2 = t.apply(v1.x, v1.y);
-            add_vertex(v2.x, v2.y, v1.on_curve);
-        }
+    if(box.empty())
+    {
+        box = transformed_box(s.m_min_x, s.m_min_y, s.m_max_x, s.m_max_y, t);
     }
+
+    m_min_x = uninitialized ? box.min_x : std::min(box.min_x, m_min_x);
+    m_min_y = uninitialized ? box.min_y : std::min(box.min_y, m_min_y);
+    m_max_x = uninitialized ? box.max_x : std::max(box.max_x, m_max_x);
+    m_max_y = uninitialized ? box.max_y : std::max(box.max_y, m_max_y);
+    m_flat &= s.m_flat;
 }
 
 void shape::transform(wttf::transform const & t)
@@ -69,23 +198,21 @@ void shape::transform(wttf::transform const & t)
     if(empty())
         return;
 
-    auto const minp = t.apply(m_min_x, m_min_y);
-    auto const maxp = t.apply(m_max_x, m_max_y);
-
-    m_min_x = minp.x;
-    m_min_y = minp.y;
-    m_max_x = maxp.x;
-    m_max_y = maxp.y;
-
+    auto box = bounding_box{};
     for(auto & cont: m_contours)
     {
-        for(auto & v1: cont)
-        {
-            auto v2 = t.apply(v1.x, v1.y);
-            v1.x = v2.x;
-            v1.y = v2.y;
-        }
+        transform_vertices(cont.data(), cont.data(), cont.size(), t, box);
+    }
+
+    if(box.empty())
+    {
+        box = transformed_box(m_min_x, m_min_y, m_max_x, m_max_y, t);
     }
+
+    m_min_x = box.min_x;
+    m_min_y = box.min_y;
+    m_max_x = box.max_x;
+    m_max_y = box.max_y;
 }
 
 void shape::scale(float sx, float sy)
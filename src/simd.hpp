@@ -0,0 +1,15 @@
+#ifndef WTTF_SIMD_HPP
+#define WTTF_SIMD_HPP
+
+/*
+ * Instruction sets every translation unit may use unconditionally, because
+ * the compiler targets them. Kernels for newer instruction sets are built
+ * separately and selected at runtime, see coverage_kernel.hpp.
+ */
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WTTF_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#endif /* WTTF_SIMD_HPP */
@@ -1,11 +1,55 @@
 #include <wttf/typeface.hpp>
 #include "typeface_p.hpp"
+#include "font_validation.hpp"
+#include "parallel.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
+#include <mutex>
+#include <unordered_map>
 
 namespace wttf
 {
 
+namespace
+{
+
+std::int16_t to_font_units(float v)
+{
+    return static_cast<std::int16_t>(
+        std::lround(std::clamp(v, -32768.0f, 32767.0f)));
+}
+
+// Builder, which rounds the points to whole font units
+struct outline_builder
+{
+    void add_contour(std::size_t s)
+    {
+        result.add_contour(s);
+    }
+
+    void add_vertex(float x, float y, bool on_curve)
+    {
+        result.add_vertex(to_font_units(x), to_font_units(y), on_curve);
+    }
+
+    outline & result;
+};
+
+// Font data read from the file on demand, or nullptr if it can't be opened
+std::shared_ptr<font_data const> open_font_file(
+    std::filesystem::path const & path)
+{
+    auto file = std::make_shared<detail::font_file const>(path);
+    if(!*file)
+        return nullptr;
+
+    return std::make_shared<font_data const>(std::move(file));
+}
+
+} /* namespace */
+
 /* class: typeface */
 typeface::typeface() = default;
 typeface::typeface(typeface const &) = default;
@@ -17,10 +61,22 @@ typeface::typeface(std::vector<std::byte> && data):
         0}
 {}
 
+typeface::typeface(std::filesystem::path const & file):
+    typeface{open_font_file(file), 0}
+{}
+
 typeface::typeface(
     std::shared_ptr<font_data const> const & data, std::size_t offset):
-    m_impl{std::make_shared<implementation>(data, offset)}
-{}
+    m_error{
+        data ?
+            detail::validate_tables(*data, offset) :
+            font_error::bad_file}
+{
+    if(m_error == font_error::none)
+    {
+        m_impl = std::make_shared<implementation>(data, offset);
+    }
+}
 
 typeface::~typeface() = default;
 
@@ -31,6 +87,16 @@ typeface::operator bool() const
     return m_impl != nullptr;
 }
 
+font_error typeface::error() const
+{
+    return m_impl ? m_impl->error() : m_error;
+}
+
+std::size_t typeface::num_glyphs() const
+{
+    return m_impl->num_glyphs();
+}
+
 std::size_t typeface::glyph_index(unsigned int codepoint) const
 {
     return m_impl->glyph_index(codepoint);
@@ -41,6 +107,28 @@ shape typeface::glyph_shape(std::uint16_t index) const
     return m_impl->glyph_shape(index);
 }
 
+outline typeface::glyph_outline(std::uint16_t index) const
+{
+    return m_impl->glyph_outline(index);
+}
+
+outline_store typeface::glyph_outlines(std::size_t threads) const
+{
+    auto glyphs = std::vector<std::uint16_t>(m_impl->num_glyphs());
+    for(auto i = std::size_t{0}; i != glyphs.size(); ++i)
+    {
+        glyphs[i] = static_cast<std::uint16_t>(i);
+    }
+
+    return m_impl->glyph_outlines(glyphs, threads);
+}
+
+outline_store typeface::glyph_outlines(
+    std::vector<std::uint16_t> const & glyphs, std::size_t threads) const
+{
+    return m_impl->glyph_outlines(glyphs, threads);
+}
+
 glyph_metrics typeface::metrics(std::uint16_t index) const
 {
     return m_impl->metrics(index);
@@ -56,13 +144,81 @@ float typeface::kerning(std::uint16_t glyph1, std::uint16_t glyph2) const
     return m_impl->kerning(glyph1, glyph2);
 }
 
+font_subset typeface::subset(std::vector<std::uint16_t> const & glyphs) const
+{
+    return m_impl->subset(glyphs, nullptr);
+}
+
+font_subset typeface::subset_codepoints(
+    std::vector<unsigned int> const & codepoints) const
+{
+    auto glyphs = std::vector<std::uint16_t>{};
+    glyphs.reserve(codepoints.size());
+    for(auto const c: codepoints)
+    {
+        glyphs.push_back(static_cast<std::uint16_t>(m_impl->glyph_index(c)));
+    }
+
+    return m_impl->subset(glyphs, &codepoints);
+}
+
 /* class: typeface::implementation */
 typeface::implementation::implementation(
     std::shared_ptr<font_data const> const & data, std::size_t offset):
     m_data{data},
     m_data_offset{offset}
 {
-    auto const cmap = find_table("cmap");
+    // Only the small fixed size tables are read here. Others are checked
+    // and parsed on first use.
+    auto const head = find_table("head");
+    m_index_to_loc_format = get<std::uint16_t>(head + 50);
+
+    auto const maxp = find_table("maxp");
+    m_num_glyphs = maxp ? get<std::uint16_t>(maxp + 4) : 0xFFFF;
+    m_loca = find_table("loca");
+    m_glyf = find_table("glyf");
+    m_hmtx = find_table("hmtx");
+
+    auto hhea = find_table("hhea");
+    if(hhea)
+    {
+        m_metrics.ascent =
+            static_cast<float>(get<std::int16_t>(hhea + 4));
+        m_metrics.descent =
+            static_cast<float>(get<std::int16_t>(hhea + 6));
+        m_metrics.line_gap =
+            static_cast<float>(get<std::int16_t>(hhea + 8));
+        m_number_of_h_metrics = get<std::uint16_t>(hhea + 34);
+    }
+
+    m_kern = find_table("kern");
+}
+
+font_error typeface::implementation::error() const
+{
+    load_cmap();
+    load_glyphs();
+    load_kerning();
+
+    for(auto const e: {m_cmap_error, m_glyphs_error, m_kern_error})
+    {
+        if(e != font_error::none)
+            return e;
+    }
+
+    return font_error::none;
+}
+
+void typeface::implementation::parse_cmap() const
+{
+    auto const table = detail::find_table(*m_data, m_data_offset, "cmap");
+    if(!detail::valid_cmap(*m_data, table))
+    {
+        m_cmap_error = font_error::bad_cmap;
+        return;
+    }
+
+    auto const cmap = static_cast<std::uint32_t>(table.offset);
     auto const num_cmap_tables = get<std::uint16_t>(cmap + 2);
 
     for(auto i = 0u; i != num_cmap_tables; ++i)
@@ -107,87 +263,94 @@ typeface::implementation::implementation(
     }
 
     WTTF_ASSERT(m_cmap_index != 0);
+}
 
-    auto const head = find_table("head");
-    switch(get<std::uint16_t>(head + 50))
-    {
-        case 0:
-            m_glyph_offset_fn = &implementation::format0_glyph_offset;
-            break;
-        case 1:
-            m_glyph_offset_fn = &implementation::format1_glyph_offset;
-            break;
+void typeface::implementation::check_glyphs() const
+{
+    auto const loca = detail::find_table(*m_data, m_data_offset, "loca");
+    auto const glyf = detail::find_table(*m_data, m_data_offset, "glyf");
 
-        default:
-            // Unknown indexToLocFormat
-            WTTF_ASSERT(false);
-            break;
+    // Checking all glyphs would read all of glyf from the file, so they are
+    // checked when first used instead
+    if(m_data->file)
+    {
+        m_glyphs_error =
+            detail::validate_loca(loca, m_index_to_loc_format, m_num_glyphs);
+        m_loca_table = loca;
+        m_glyf_table = glyf;
+        m_glyph_checks =
+            std::make_unique<std::atomic<std::uint8_t>[]>(m_num_glyphs);
+    }
+    else
+    {
+        m_glyphs_error = detail::validate_glyphs(
+            *m_data, loca, glyf, m_index_to_loc_format, m_num_glyphs);
     }
 
-    auto const maxp = find_table("maxp");
-    m_num_glyphs = maxp ? get<std::uint16_t>(maxp + 4) : 0xFFFF;
-    m_loca = find_table("loca");
-    m_glyf = find_table("glyf");
-    m_hmtx = find_table("hmtx");
+    if(m_glyphs_error != font_error::none)
+        return;
 
-    auto hhea = find_table("hhea");
-    if(hhea)
+    m_glyph_offset_fn = m_index_to_loc_format == 0 ?
+        &implementation::format0_glyph_offset :
+        &implementation::format1_glyph_offset;
+}
+
+void typeface::implementation::parse_kerning() const
+{
+    if(!m_kern)
+        return;
+
+    if(!detail::valid_kern(
+        *m_data, detail::find_table(*m_data, m_data_offset, "kern")))
     {
-        m_metrics.ascent =
-            static_cast<float>(get<std::int16_t>(hhea + 4));
-        m_metrics.descent =
-            static_cast<float>(get<std::int16_t>(hhea + 6));
-        m_metrics.line_gap =
-            static_cast<float>(get<std::int16_t>(hhea + 8));
-        m_number_of_h_metrics = get<std::uint16_t>(hhea + 34);
+        m_kern_error = font_error::bad_kern;
+        return;
     }
 
-    m_kern = find_table("kern");
-    if(m_kern)
+    auto const version = get<std::uint16_t>(m_kern);
+    auto const n_tables = get<std::uint16_t>(m_kern + 2);
+    if(n_tables > 0 && version == 0) // We only know version 0
     {
-        auto const version = get<std::uint16_t>(m_kern);
-        auto const n_tables = get<std::uint16_t>(m_kern + 2);
-        if(n_tables > 0 && version == 0) // We only know version 0
+        auto find_sub_table = [n_tables, this]() -> std::uint32_t
         {
-            auto find_sub_table = [n_tables, this]() -> std::uint32_t
+            auto offset = m_kern + 4;
+            for(auto table = 0u; table != n_tables; ++table)
             {
-                auto offset = m_kern + 4;
-                for(auto table = 0u; table != n_tables; ++table)
+                auto const version = get<std::uint16_t>(offset);
+                auto const length = get<std::uint16_t>(offset + 2);
+                auto const coverage = get<std::uint16_t>(offset + 4);
+                auto const format = coverage >> 8;
+                auto const horizontal = ((coverage & 1) != 0);
+                if(version == 0 && format == 0 && horizontal)
                 {
-                    auto const version = get<std::uint16_t>(offset);
-                    auto const length = get<std::uint16_t>(offset + 2);
-                    auto const coverage = get<std::uint16_t>(offset + 4);
-                    auto const format = coverage >> 8;
-                    auto const horizontal = ((coverage & 1) != 0);
-                    if(version == 0 && format == 0 && horizontal)
-                    {
-                        return offset;
-                    }
-                    offset += length;
+                    return offset;
                 }
+                offset += length;
+            }
 
-                return 0;
-            };
+            return 0;
+        };
 
-            auto const sub_table = find_sub_table();
-            auto const n_pairs = get<std::uint16_t>(sub_table + 6);
+        auto const sub_table = find_sub_table();
+        auto const n_pairs = sub_table ?
+            get<std::uint16_t>(sub_table + 6) : std::uint16_t{0};
 
-            auto stream = m_data->create_cursor(sub_table+14);
-            for(auto i = 0u; i !=n_pairs; ++i)
-            {
-                auto const left = stream.read<std::uint16_t>();
-                auto const right = stream.read<std::uint16_t>();
-                auto const value = stream.read<std::int16_t>();
-                m_kerning_tables[left][right] = static_cast<float>(value);
-            }
+        auto stream = m_data->create_cursor(sub_table+14);
+        for(auto i = 0u; i !=n_pairs; ++i)
+        {
+            auto const left = stream.read<std::uint16_t>();
+            auto const right = stream.read<std::uint16_t>();
+            auto const value = stream.read<std::int16_t>();
+            m_kerning_tables[left][right] = static_cast<float>(value);
         }
     }
-
 }
 
 std::size_t typeface::implementation::glyph_index(
     unsigned int codepoint) const
 {
+    load_cmap();
+
     return
         m_glyph_index_fn ?
         std::invoke(m_glyph_index_fn, this, codepoint) :
@@ -207,14 +370,181 @@ shape typeface::implementation::glyph_shape(std::uint16_t glyph_index) const
     }
     else if(num_contours < 0)
     {
-        return composite_glyph_shape(glyph_offs);
+        return composite_glyph_shape(glyph_index, glyph_offs);
     }
 
     return {};
 }
 
+outline typeface::implementation::glyph_outline(
+    std::uint16_t glyph_index) const
+{
+    auto result = outline{};
+    auto builder = outline_builder{result};
+    decode_glyph(
+        glyph_index, transform::from_scale_translate(1.0f, {0.0f, 0.0f}),
+        builder);
+    result.shrink_to_fit();
+
+    return result;
+}
+
+outline_store typeface::implementation::glyph_outlines(
+    std::vector<std::uint16_t> const & glyphs, std::size_t threads) const
+{
+    // Simple glyph, transformed, as a part of the outline of a stored glyph
+    struct part
+    {
+        std::uint32_t source;
+        transform t;
+    };
+
+    auto result = outline_store{};
+    result.m_index.assign(m_num_glyphs, outline_store::no_entry);
+
+    // Resolve the composite glyphs first, so that each simple glyph is
+    // decoded only once, even if it is a component of many glyphs.
+    auto sources = std::vector<std::uint32_t>{};
+    auto source_index = std::unordered_map<std::uint32_t, std::uint32_t>{};
+    auto parts = std::vector<part>{};
+    auto first_parts = std::vector<std::size_t>{};
+
+    for(auto const glyph_index: glyphs)
+    {
+        if(glyph_index >= m_num_glyphs ||
+            result.m_index[glyph_index] != outline_store::no_entry)
+            continue;
+
+        result.m_index[glyph_index] =
+            static_cast<std::uint32_t>(first_parts.size());
+        first_parts.push_back(parts.size());
+
+        for_each_simple_glyph(
+            glyph_index, transform::from_scale_translate(1.0f, {0.0f, 0.0f}),
+            [&](std::uint32_t glyph_offs, transform const & t)
+            {
+                auto const [it, inserted] = source_index.try_emplace(
+                    glyph_offs, static_cast<std::uint32_t>(sources.size()));
+                if(inserted)
+                {
+                    sources.push_back(glyph_offs);
+                }
+                parts.push_back({it->second, t});
+            });
+    }
+    first_parts.push_back(parts.size());
+
+    auto decoded = std::vector<outline>(sources.size());
+    detail::parallel_for(
+        sources.size(), threads,
+        [&sources, &decoded, this](std::size_t i)
+        {
+            auto builder = outline_builder{decoded[i]};
+            decode_simple_glyph(sources[i], builder);
+        });
+
+    // Layout of the shared arrays
+    auto const num_entries = first_parts.size() - 1;
+    result.m_entries.resize(num_entries);
+
+    auto num_points = std::size_t{0};
+    auto num_flag_bytes = std::size_t{0};
+    auto num_contours = std::size_t{0};
+    for(auto i = std::size_t{0}; i != num_entries; ++i)
+    {
+        auto & e = result.m_entries[i];
+        e.first_point = static_cast<std::uint32_t>(num_points);
+        e.first_flag_byte = static_cast<std::uint32_t>(num_flag_bytes);
+        e.first_contour = static_cast<std::uint32_t>(num_contours);
+
+        auto points = std::size_t{0};
+        auto contours = std::size_t{0};
+        for(auto p = first_parts[i]; p != first_parts[i+1]; ++p)
+        {
+            auto const & o = decoded[parts[p].source];
+            points += o.num_points();
+            contours += o.num_contours();
+        }
+
+        e.num_contours = static_cast<std::uint32_t>(contours);
+        num_points += points;
+        num_flag_bytes += (points + 7) / 8;
+        num_contours += contours;
+    }
+
+    result.m_points.resize(num_points);
+    result.m_on_curve.resize(num_flag_bytes);
+    result.m_contour_ends.resize(num_contours);
+
+    // Each glyph writes only its own part of the arrays
+    detail::parallel_for(
+        num_entries, threads,
+        [&result, &parts, &first_parts, &decoded](std::size_t i)
+        {
+            auto & e = result.m_entries[i];
+            auto * const points = result.m_points.data() + e.first_point;
+            auto * const on_curve =
+                result.m_on_curve.data() + e.first_flag_byte;
+            auto * contour_end =
+                result.m_contour_ends.data() + e.first_contour;
+            auto n = std::size_t{0};
+
+            for(auto p = first_parts[i]; p != first_parts[i+1]; ++p)
+            {
+                auto const & o = decoded[parts[p].source];
+                auto const & t = parts[p].t;
+
+                for(auto c = std::size_t{0}; c != o.num_contours(); ++c)
+                {
+                    for(auto j = o.contour_start(c); j != o.contour_end(c); ++j)
+                    {
+                        auto const & src = o.position(j);
+                        auto const v = t.apply(
+                            static_cast<float>(src.x),
+                            static_cast<float>(src.y));
+                        auto const x = to_font_units(v.x);
+                        auto const y = to_font_units(v.y);
+
+                        if(n == 0)
+                        {
+                            e.min_x = e.max_x = x;
+                            e.min_y = e.max_y = y;
+                        }
+                        else
+                        {
+                            e.min_x = std::min(e.min_x, x);
+                            e.min_y = std::min(e.min_y, y);
+                            e.max_x = std::max(e.max_x, x);
+                            e.max_y = std::max(e.max_y, y);
+                        }
+
+                        points[n] = {x, y};
+                        if(o.on_curve(j))
+                        {
+                            on_curve[n / 8] |=
+                                static_cast<std::uint8_t>(1u << (n % 8));
+                        }
+                        ++n;
+                    }
+
+                    *contour_end++ = static_cast<std::uint32_t>(n);
+                }
+            }
+
+            if(n == 0)
+            {
+                e.min_x = e.min_y = e.max_x = e.max_y = 0;
+            }
+        });
+
+    return result;
+}
+
 glyph_metrics typeface::implementation::metrics(std::uint16_t glyph_index) const
 {
+    if(glyph_index >= m_num_glyphs)
+        return {};
+
     auto adv = 0.0f;
     auto lsb = 0.0f;
 
@@ -234,7 +564,10 @@ glyph_metrics typeface::implementation::metrics(std::uint16_t glyph_index) const
                 2 * (glyph_index - m_number_of_h_metrics)));
     }
 
+    // Empty and invalid glyphs have no glyph record to read the box from
     auto const offset = glyph_offset(glyph_index);
+    if(!offset)
+        return {lsb, adv, 0.0f, 0.0f, 0.0f, 0.0f};
 
     auto const x_min = static_cast<float>(get<std::int16_t>(offset + 2));
     auto const y_min = static_cast<float>(get<std::int16_t>(offset + 4));
@@ -252,6 +585,8 @@ font_metrics const & typeface::implementation::metrics() const
 float typeface::implementation::kerning(
     std::uint16_t glyph1, std::uint16_t glyph2) const
 {
+    load_kerning();
+
     if(m_kern == 0)
     {
         return 0.0f;
@@ -310,9 +645,16 @@ std::uint16_t typeface::implementation::format4_glyph_index(
     }
 
     auto const seg_count = get<std::uint16_t>(m_cmap_index+6)/2u;
-    auto search_range = get<std::uint16_t>(m_cmap_index+8);
-    auto entry_selector = get<std::uint16_t>(m_cmap_index+10);
-    auto const range_shift = get<std::uint16_t>(m_cmap_index+12);
+
+    // searchRange, entrySelector and rangeShift only repeat what the segment
+    // count tells, and are often wrong in fonts, so they are not read
+    auto entry_selector = 0u;
+    while((2u << entry_selector) <= seg_count)
+    {
+        ++entry_selector;
+    }
+    auto search_range = 2u << entry_selector;
+    auto const range_shift = seg_count*2u - search_range;
 
     auto const end_count = m_cmap_index + 14u;
     auto search = end_count;
@@ -388,113 +730,73 @@ std::uint32_t typeface::implementation::format1_glyph_offset(
     return g1==g2 ? 0 : g1;
 }
 
-std::uint32_t typeface::implementation::glyph_offset(
+std::uint32_t typeface::implementation::glyph_size(
     std::uint16_t glyph_index) const
 {
-    return
-        (glyph_index >= m_num_glyphs || m_glyph_offset_fn == nullptr) ?
-        0u :
-        std::invoke(m_glyph_offset_fn, this, glyph_index);
-}
-
-shape typeface::implementation::simple_glyph_shape(
-        std::uint32_t const glyph_offset) const
-{
-    auto const gh = get<glyph_header>(glyph_offset);
-    auto const number_of_contours =
-        static_cast<std::uint16_t>(gh.number_of_contours);
+    auto const offset = glyph_offset(glyph_index);
+    if(!offset)
+        return 0;
 
-    struct vertex
-    {
-        std::int16_t x{0};
-        std::int16_t y{0};
-        std::uint8_t flags{0};
-    };
+    auto const end = m_index_to_loc_format == 0 ?
+        m_glyf + get<std::uint16_t>(m_loca + glyph_index * 2 + 2) * 2u :
+        m_glyf + get<std::uint32_t>(m_loca + glyph_index * 4 + 4);
 
-    auto const end_pts_of_countours_offset =
-        glyph_offset + glyph_header::byte_size;
-    auto const instruction_length = get<std::uint16_t>(
-        end_pts_of_countours_offset +
-        number_of_contours * 2u);
+    return end - offset;
+}
 
-    auto end_pts = m_data->create_cursor(end_pts_of_countours_offset);
-    auto points = m_data->create_cursor(
-            end_pts_of_countours_offset +
-            number_of_contours*2u +
-            2u +
-            instruction_length);
+std::uint32_t typeface::implementation::glyph_offset(
+    std::uint16_t glyph_index) const
+{
+    load_glyphs();
 
-    auto const num_points =
-        std::size_t{1} +
-        end_pts.peek<std::uint16_t>((number_of_contours-1u) * 2u);
+    if(glyph_index >= m_num_glyphs || m_glyph_offset_fn == nullptr ||
+        (m_glyph_checks && !check_glyph(glyph_index)))
+        return 0u;
 
-    auto vertices = std::vector<vertex>{num_points};
+    return std::invoke(m_glyph_offset_fn, this, glyph_index);
+}
 
-    // Read flags
-    auto repeat = 0u;
-    auto current_flags = std::uint8_t{0};
-    for(auto i=0u; i < num_points; ++i)
+bool typeface::implementation::check_glyph(
+    std::uint16_t glyph_index, unsigned depth) const
+{
+    // Acquire and release, so that the pages loaded by the thread checking
+    // the glyph are seen by the others. Threads checking the same glyph at
+    // once get the same result.
+    auto & check = m_glyph_checks[glyph_index];
+    auto state = check.load(std::memory_order_acquire);
+    if(state == 0)
     {
-        if(repeat == 0)
-        {
-            current_flags = points.read<std::uint8_t>();
-            if(current_flags & 8)
-            {
-                repeat = points.read<std::uint8_t>();
-            }
-        }
-        else
+        auto valid = detail::validate_glyph(
+            *m_data, m_loca_table, m_glyf_table, m_index_to_loc_format,
+            m_num_glyphs, glyph_index) == font_error::none;
+
+        // Otherwise a component, which can't be read, would be left out of
+        // the glyph. Cyclic references end at the depth limit.
+        auto const glyph_offs = valid ?
+            std::invoke(m_glyph_offset_fn, this, glyph_index) :
+            0u;
+        if(glyph_offs && get<std::int16_t>(glyph_offs) < 0 &&
+            depth < max_component_depth)
         {
-            --repeat;
+            for_each_component(
+                glyph_offs,
+                [this, depth, &valid](std::uint16_t index, transform const &)
+                {
+                    valid = valid && check_glyph(index, depth + 1);
+                });
         }
-        vertices[i].flags = current_flags;
-    }
 
-    // Read x coordinates
-    auto current_x = std::int16_t{0};
-    for(auto i=0u; i < num_points; ++i)
-    {
-        auto & v = vertices[i];
-        current_flags = v.flags;
-        if(current_flags & simple_glyph_flags::x_short_vector)
-        {
-            auto const x = points.read<std::uint8_t>();
-            current_x +=
-                (current_flags & simple_glyph_flags::x_is_same_or_positive_x_short_vector) ?
-                x : -x;
-        }
-        else
-        {
-            if(!(current_flags & simple_glyph_flags::x_is_same_or_positive_x_short_vector))
-            {
-                current_x += points.read<std::int16_t>();
-            }
-        }
-        v.x = current_x;
+        state = valid ? glyph_valid : glyph_invalid;
+        check.store(state, std::memory_order_release);
     }
 
-    // Read y coordinates
-    auto current_y = std::int16_t{0};
-    for(auto i=0u; i < num_points; ++i)
-    {
-        auto & v = vertices[i];
-        current_flags = v.flags;
-        if(current_flags & simple_glyph_flags::y_short_vector)
-        {
-            auto const y = points.read<std::uint8_t>();
-            current_y +=
-                (current_flags & simple_glyph_flags::y_is_same_or_positive_y_short_vector) ?
-                y : -y;
-        }
-        else
-        {
-            if(!(current_flags & simple_glyph_flags::y_is_same_or_positive_y_short_vector))
-            {
-                current_y += points.read<std::int16_t>();
-            }
-        }
-        v.y = current_y;
-    }
+    return state == glyph_valid;
+}
+
+shape typeface::implementation::simple_glyph_shape(
+        std::uint32_t const glyph_offset) const
+{
+    auto const gh = get<glyph_header>(glyph_offset);
 
     auto s = shape{
         static_cast<float>(gh.x_min),
@@ -503,97 +805,49 @@ shape typeface::implementation::simple_glyph_shape(
         static_cast<float>(gh.y_max),
         static_cast<std::size_t>(gh.number_of_contours)};
 
-    auto next_contour = std::uint16_t{0};
-    for(auto i=0u; i < num_points; ++i)
-    {
-        if(next_contour == i)
-        {
-            next_contour = end_pts.read<std::uint16_t>() + 1;
-            s.add_contour(next_contour-i);
-        }
-
-        auto & v = vertices[i];
-        s.add_vertex(v.x, v.y, v.flags & simple_glyph_flags::on_curve_point);
-    }
+    decode_simple_glyph(glyph_offset, s);
 
     return s;
 }
 
 shape typeface::implementation::composite_glyph_shape(
-        std::uint32_t const glyph_offset) const
+        std::uint16_t const glyph_index, std::uint32_t const glyph_offset) const
 {
-    auto data = m_data->create_cursor(glyph_offset+10);
-
-    auto flags =
-        static_cast<uint16_t>(composite_glyph_flags::more_components);
-
-    auto result = shape{};
+    auto const gh = get<glyph_header>(glyph_offset);
 
-    while(flags & composite_glyph_flags::more_components)
-    {
-        flags = data.read<std::uint16_t>();
-        auto glyph_index = data.read<std::uint16_t>();
+    // Components are transformed straight into the result, instead of
+    // building and copying a shape for each of them
+    auto s = shape{
+        static_cast<float>(gh.x_min),
+        static_cast<float>(gh.y_min),
+        static_cast<float>(gh.x_max),
+        static_cast<float>(gh.y_max)};
 
-        auto p = point{0.0f, 0.0f};
+    decode_glyph(
+        glyph_index, transform::from_scale_translate(1.0f, {0.0f, 0.0f}), s);
 
-        if(flags & composite_glyph_flags::args_are_xy_values)
-        {
-            if(flags & composite_glyph_flags::arg_1_and_arg_2_are_words)
-            {
-                p.x = data.read<std::int16_t>();
-                p.y = data.read<std::int16_t>();
-            }
-            else
-            {
-                p.x = data.read<std::int8_t>();
-                p.y = data.read<std::int8_t>();
-            }
-        }
-        else
-        {
-            if(flags & composite_glyph_flags::arg_1_and_arg_2_are_words)
-            {
-                data.read<std::uint16_t>();
-                data.read<std::uint16_t>();
-            }
-            else
-            {
-                data.read<std::uint8_t>();
-                data.read<std::uint8_t>();
-            }
-        }
+    return s;
+}
 
-        if(flags & composite_glyph_flags::we_have_a_scale)
-        {
-            auto const scale = data.read<std::int16_t>()/16384.0f;
-            auto const t = transform::from_scale_translate(scale, p);
-            result.add_shape(glyph_shape(glyph_index), t);
-        }
-        else if(flags & composite_glyph_flags::we_have_x_and_y_scale)
-        {
-            auto const sx = data.read<std::int16_t>()/16384.0f;
-            auto const sy = data.read<std::int16_t>()/16384.0f;
-            auto const t = transform::from_scale_translate({sx, sy}, p);
-            result.add_shape(glyph_shape(glyph_index), t);
-        }
-        else if(flags & composite_glyph_flags::we_have_a_two_by_two)
-        {
-            auto m = std::array<float, 4>{};
-            for(auto & e: m)
-            {
-                e = data.read<std::int16_t>()/16384.0f;
-            }
-            auto const t = transform{m[0], m[1], m[2], m[3], p.x, p.y};
-            result.add_shape(glyph_shape(glyph_index), t);
-        }
-        else
-        {
-            auto const t = transform::from_scale_translate(1.0f, p);
-            result.add_shape(glyph_shape(glyph_index), t);
-        }
+outline const & typeface::implementation::component_outline(
+    std::uint32_t const glyph_offset) const
+{
+    {
+        auto const lock = std::shared_lock{m_components_mutex};
+        auto const it = m_components.find(glyph_offset);
+        if(it != m_components.end())
+            return *it->second;
     }
 
-    return result;
+    auto o = std::make_unique<outline>();
+    auto builder = outline_builder{*o};
+    decode_simple_glyph(glyph_offset, builder);
+    o->shrink_to_fit();
+
+    // Another thread may have decoded the same glyph meanwhile. Either copy
+    // will do, as they are equal.
+    auto const lock = std::unique_lock{m_components_mutex};
+    return *m_components.try_emplace(glyph_offset, std::move(o)).first->second;
 }
 
 }
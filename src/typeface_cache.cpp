@@ -0,0 +1,302 @@
+#include <wttf/typeface_cache.hpp>
+#include <wttf/typeface.hpp>
+#include "typeface_p.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace wttf
+{
+
+namespace
+{
+
+// 'wttf' when read in the byte order the blob was written in
+constexpr std::uint32_t cache_magic = 0x66747477;
+// Version 2: empty glyphs have a zero box, instead of bytes of the header
+constexpr std::uint32_t cache_version = 2;
+
+constexpr std::size_t cmap_page_size = 256;
+constexpr std::size_t num_metrics_fields = 6;
+
+// Array in the blob, count elements starting offset bytes from the start
+struct cache_section
+{
+    std::uint32_t offset;
+    std::uint32_t count;
+};
+
+struct cache_header
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t num_glyphs;
+    float ascent;
+    float descent;
+    float line_gap;
+    cache_section cmap_index;
+    cache_section cmap_pages;
+    cache_section glyph_metrics;
+    cache_section kerning_pairs;
+    cache_section kerning_values;
+    cache_section outline_index;
+    cache_section outline_entries;
+    cache_section points;
+    cache_section on_curve;
+    cache_section contour_ends;
+};
+
+// Everything in the blob is aligned to this
+constexpr std::size_t cache_alignment = 4;
+static_assert(alignof(cache_header) == cache_alignment);
+static_assert(alignof(outline_store::entry) <= cache_alignment);
+
+template <typename T>
+cache_section append(std::vector<std::byte> & blob, std::vector<T> const & v)
+{
+    blob.resize((blob.size() + cache_alignment - 1) & ~(cache_alignment - 1));
+
+    auto const s = cache_section{
+        static_cast<std::uint32_t>(blob.size()),
+        static_cast<std::uint32_t>(v.size())};
+
+    blob.resize(blob.size() + v.size() * sizeof(T));
+    if(!v.empty())
+        std::memcpy(blob.data() + s.offset, v.data(), v.size() * sizeof(T));
+
+    return s;
+}
+
+// Pointer to a section, or nullptr if it is not inside the data
+template <typename T>
+T const * section_data(
+    std::byte const * data, std::size_t size, cache_section const & s)
+{
+    if(s.offset % cache_alignment != 0 || s.offset > size ||
+        s.count > (size - s.offset) / sizeof(T))
+        return nullptr;
+
+    return static_cast<T const *>(static_cast<void const *>(data + s.offset));
+}
+
+} /* namespace */
+
+typeface_cache::typeface_cache(void const * data, std::size_t size)
+{
+    auto const bytes = static_cast<std::byte const *>(data);
+    if(!bytes ||
+        reinterpret_cast<std::uintptr_t>(bytes) % cache_alignment != 0 ||
+        size < sizeof(cache_header))
+        return;
+
+    auto const & h = *static_cast<cache_header const *>(data);
+    if(h.magic != cache_magic || h.version != cache_version)
+        return;
+
+    auto const cmap_index =
+        section_data<std::uint16_t>(bytes, size, h.cmap_index);
+    auto const cmap_pages =
+        section_data<std::uint16_t>(bytes, size, h.cmap_pages);
+    auto const glyph_metrics =
+        section_data<float>(bytes, size, h.glyph_metrics);
+    auto const kerning_pairs =
+        section_data<std::uint32_t>(bytes, size, h.kerning_pairs);
+    auto const kerning_values =
+        section_data<float>(bytes, size, h.kerning_values);
+    auto const outline_index =
+        section_data<std::uint32_t>(bytes, size, h.outline_index);
+    auto const outline_entries =
+        section_data<outline_store::entry>(bytes, size, h.outline_entries);
+    auto const points =
+        section_data<outline_view::coordinate>(bytes, size, h.points);
+    auto const on_curve =
+        section_data<std::uint8_t>(bytes, size, h.on_curve);
+    auto const contour_ends =
+        section_data<std::uint32_t>(bytes, size, h.contour_ends);
+
+    if(!cmap_index || !cmap_pages || !glyph_metrics || !kerning_pairs ||
+        !kerning_values || !outline_index || !outline_entries || !points ||
+        !on_curve || !contour_ends)
+        return;
+
+    if(h.cmap_pages.count % cmap_page_size != 0 ||
+        h.glyph_metrics.count != h.num_glyphs * num_metrics_fields ||
+        h.kerning_values.count != h.kerning_pairs.count ||
+        (h.outline_index.count != 0 &&
+            h.outline_index.count != h.num_glyphs))
+        return;
+
+    m_tables.num_glyphs = h.num_glyphs;
+    m_tables.metrics = {h.ascent, h.descent, h.line_gap};
+    m_tables.cmap_index = cmap_index;
+    m_tables.cmap_index_size = h.cmap_index.count;
+    m_tables.cmap_pages = cmap_pages;
+    m_tables.num_cmap_pages = h.cmap_pages.count / cmap_page_size;
+    m_tables.glyph_metrics = glyph_metrics;
+    m_tables.kerning_pairs = kerning_pairs;
+    m_tables.kerning_values = kerning_values;
+    m_tables.num_kerning_pairs = h.kerning_pairs.count;
+
+    if(h.outline_index.count != 0)
+    {
+        m_tables.outline_index = outline_index;
+        m_tables.outline_entries = outline_entries;
+        m_tables.num_outline_entries = h.outline_entries.count;
+        m_tables.points = points;
+        m_tables.num_points = h.points.count;
+        m_tables.on_curve = on_curve;
+        m_tables.num_on_curve_bytes = h.on_curve.count;
+        m_tables.contour_ends = contour_ends;
+        m_tables.num_contour_ends = h.contour_ends.count;
+    }
+}
+
+std::vector<std::byte> typeface_cache::serialize(
+    typeface const & face, bool with_outlines, std::size_t threads)
+{
+    if(!face)
+        return {};
+
+    auto const & impl = *face.m_impl;
+    auto const num_glyphs = impl.num_glyphs();
+
+    // Character map is split into pages of 256 codepoints. Pages without
+    // any glyphs share the first page, which is all zeros.
+    auto cmap_index = std::vector<std::uint16_t>{};
+    auto cmap_pages = std::vector<std::uint16_t>(cmap_page_size);
+    auto page = std::array<std::uint16_t, cmap_page_size>{};
+
+    for(auto first = 0u; first <= 0xFFFFu; first += cmap_page_size)
+    {
+        auto used = false;
+        for(auto i = 0u; i != cmap_page_size; ++i)
+        {
+            page[i] = static_cast<std::uint16_t>(impl.glyph_index(first + i));
+            used = used || page[i] != 0;
+        }
+
+        if(!used)
+        {
+            cmap_index.push_back(0);
+            continue;
+        }
+
+        cmap_index.push_back(
+            static_cast<std::uint16_t>(cmap_pages.size() / cmap_page_size));
+        cmap_pages.insert(cmap_pages.end(), page.begin(), page.end());
+    }
+
+    while(!cmap_index.empty() && cmap_index.back() == 0)
+    {
+        cmap_index.pop_back();
+    }
+
+    auto glyph_metrics = std::vector<float>(num_glyphs * num_metrics_fields);
+    for(auto g = std::size_t{0}; g != num_glyphs; ++g)
+    {
+        auto const m = impl.metrics(static_cast<std::uint16_t>(g));
+        auto const fields = std::array<float, num_metrics_fields>{
+            m.left_side_bearing, m.advance, m.x_min, m.y_min, m.x_max, m.y_max};
+
+        for(auto f = std::size_t{0}; f != num_metrics_fields; ++f)
+        {
+            glyph_metrics[f * num_glyphs + g] = fields[f];
+        }
+    }
+
+    auto kerning_pairs = std::vector<std::uint32_t>{};
+    auto kerning_values = std::vector<float>{};
+    impl.for_each_kerning_pair(
+        [&](std::uint16_t glyph1, std::uint16_t glyph2, float value)
+        {
+            kerning_pairs.push_back(std::uint32_t{glyph1} << 16 | glyph2);
+            kerning_values.push_back(value);
+        });
+
+    auto outlines = outline_store{};
+    if(with_outlines)
+    {
+        outlines = face.glyph_outlines(threads);
+    }
+
+    auto blob = std::vector<std::byte>(sizeof(cache_header));
+    auto h = cache_header{};
+    h.magic = cache_magic;
+    h.version = cache_version;
+    h.num_glyphs = static_cast<std::uint32_t>(num_glyphs);
+    h.ascent = impl.metrics().ascent;
+    h.descent = impl.metrics().descent;
+    h.line_gap = impl.metrics().line_gap;
+    h.cmap_index = append(blob, cmap_index);
+    h.cmap_pages = append(blob, cmap_pages);
+    h.glyph_metrics = append(blob, glyph_metrics);
+    h.kerning_pairs = append(blob, kerning_pairs);
+    h.kerning_values = append(blob, kerning_values);
+    h.outline_index = append(blob, outlines.m_index);
+    h.outline_entries = append(blob, outlines.m_entries);
+    h.points = append(blob, outlines.m_points);
+    h.on_curve = append(blob, outlines.m_on_curve);
+    h.contour_ends = append(blob, outlines.m_contour_ends);
+    std::memcpy(blob.data(), &h, sizeof(h));
+
+    return blob;
+}
+
+std::size_t typeface_cache::glyph_index(unsigned int codepoint) const
+{
+    auto const & t = m_tables;
+    auto const page = codepoint / cmap_page_size;
+    if(page >= t.cmap_index_size || t.cmap_index[page] >= t.num_cmap_pages)
+        return 0;
+
+    return t.cmap_pages[
+        t.cmap_index[page] * cmap_page_size + codepoint % cmap_page_size];
+}
+
+glyph_metrics typeface_cache::metrics(std::uint16_t index) const
+{
+    auto const & t = m_tables;
+    if(index >= t.num_glyphs)
+        return {};
+
+    auto const field = [&t, index](std::size_t f)
+    {
+        return t.glyph_metrics[f * t.num_glyphs + index];
+    };
+
+    return {field(0), field(1), field(2), field(3), field(4), field(5)};
+}
+
+float typeface_cache::kerning(std::uint16_t glyph1, std::uint16_t glyph2) const
+{
+    auto const & t = m_tables;
+    auto const pair = std::uint32_t{glyph1} << 16 | glyph2;
+    auto const last = t.kerning_pairs + t.num_kerning_pairs;
+    auto const it = std::lower_bound(t.kerning_pairs, last, pair);
+    if(it == last || *it != pair)
+        return 0.0f;
+
+    return t.kerning_values[it - t.kerning_pairs];
+}
+
+outline_view typeface_cache::glyph_outline(std::uint16_t index) const
+{
+    auto const & t = m_tables;
+    if(!t.outline_index || index >= t.num_glyphs ||
+        t.outline_index[index] >= t.num_outline_entries)
+        return {};
+
+    auto const & e = t.outline_entries[t.outline_index[index]];
+    return {
+        t.points + e.first_point,
+        t.on_curve + e.first_flag_byte,
+        t.contour_ends + e.first_contour,
+        e.num_contours,
+        e.min_x, e.min_y, e.max_x, e.max_y};
+}
+
+} /* namespace wttf */
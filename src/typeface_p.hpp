@@ -3,6 +3,17 @@
 
 #include <wttf/typeface.hpp>
 #include "font_data.hpp"
+#include "font_validation.hpp"
+#include "once.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
 
 namespace wttf
 {
@@ -17,12 +28,47 @@ class typeface::implementation
     implementation(
         std::shared_ptr<font_data const> const & data, std::size_t offset);
 
+    // Composite glyphs nested deeper, or made of more components than this,
+    // are cut short. Protects against malformed fonts with cyclic or
+    // exponentially growing references.
+    static constexpr unsigned max_component_depth = 16;
+    static constexpr unsigned max_components = 1024;
+
+    // Checks all tables, which have not been used yet. Glyphs of a font read
+    // from a file are checked one by one, when first used, and not here.
+    [[nodiscard]] font_error error() const;
+
+    [[nodiscard]] std::size_t num_glyphs() const { return m_num_glyphs; }
     [[nodiscard]] std::size_t glyph_index(unsigned int codepoint) const;
     [[nodiscard]] shape glyph_shape(std::uint16_t index) const;
+    [[nodiscard]] outline glyph_outline(std::uint16_t index) const;
+    [[nodiscard]] outline_store glyph_outlines(
+        std::vector<std::uint16_t> const & glyphs, std::size_t threads) const;
     [[nodiscard]] glyph_metrics metrics(std::uint16_t index) const;
     [[nodiscard]] font_metrics const & metrics() const;
     [[nodiscard]] float kerning(std::uint16_t glyph1, std::uint16_t glyph2) const;
 
+    // Font data with the given glyphs, and the given codepoints in the
+    // character map, or all codepoints of the glyphs if codepoints is null
+    [[nodiscard]] font_subset subset(
+        std::vector<std::uint16_t> const & glyphs,
+        std::vector<unsigned int> const * codepoints) const;
+
+    // Calls function(glyph1, glyph2, kerning) for each kerning pair, in
+    // ascending order of glyph1, and then glyph2
+    template <typename Function>
+    void for_each_kerning_pair(Function && function) const;
+
+    /*
+     * Decodes the outline of a glyph, transformed by t, straight into a
+     * builder, without creating a shape. Builder has the same add_contour
+     * and add_vertex functions as shape.
+     */
+    template <typename Builder>
+    void decode_glyph(
+        std::uint16_t glyph_index, transform const & t,
+        Builder & builder) const;
+
     private:
     using glyph_index_fn_t =
         std::uint16_t (implementation::*)(unsigned int) const;
@@ -37,6 +83,22 @@ class typeface::implementation
 
     [[nodiscard]] std::uint32_t find_table(char const * tag) const;
 
+    // Tables are checked and parsed on first use, once for all threads. A
+    // table failing the check is treated as empty.
+    void load_cmap() const { m_cmap_once.call([this]() { parse_cmap(); }); }
+    void load_glyphs() const
+    {
+        m_glyphs_once.call([this]() { check_glyphs(); });
+    }
+    void load_kerning() const
+    {
+        m_kern_once.call([this]() { parse_kerning(); });
+    }
+
+    void parse_cmap() const;
+    void check_glyphs() const;
+    void parse_kerning() const;
+
     [[nodiscard]] std::uint16_t
     format0_glyph_index(unsigned int codepoint) const;
     [[nodiscard]] std::uint16_t
@@ -51,26 +113,390 @@ class typeface::implementation
 
     [[nodiscard]] std::uint32_t glyph_offset(std::uint16_t glyph_index) const;
 
+    // Checks a glyph of a font read from a file, once. A composite glyph is
+    // valid only if its components, up to the depth limit, are too.
+    [[nodiscard]] bool check_glyph(
+        std::uint16_t glyph_index, unsigned depth = 0u) const;
+
+    // Size of the glyph record in bytes, zero for an empty glyph
+    [[nodiscard]] std::uint32_t glyph_size(std::uint16_t glyph_index) const;
+
     [[nodiscard]] shape simple_glyph_shape(
         std::uint32_t const glyph_offset) const;
     [[nodiscard]] shape composite_glyph_shape(
+        std::uint16_t const glyph_index,
         std::uint32_t const glyph_offset) const;
 
+    // Calls builder.add_contour and builder.add_vertex for the points of a
+    // simple glyph, in font units.
+    template <typename Builder>
+    void decode_simple_glyph(
+        std::uint32_t const glyph_offset, Builder & builder) const;
+
+    // Calls function(glyph_offset, transform) for each simple glyph, which
+    // the outline of a glyph is made of, with components of composite glyphs
+    // resolved recursively, up to the component limits.
+    template <typename Function>
+    void for_each_simple_glyph(
+        std::uint16_t glyph_index, transform const & t,
+        Function && function) const;
+
+    template <typename Function>
+    void for_each_simple_glyph(
+        std::uint16_t glyph_index, transform const & t, unsigned depth,
+        unsigned & components, Function & function) const;
+
+    // Decoded outline of a simple glyph, used as a component. Decoded on
+    // first use and kept for the lifetime of the typeface.
+    [[nodiscard]] outline const & component_outline(
+        std::uint32_t const glyph_offset) const;
+
+    // Calls function(glyph_index, transform) for each component of a
+    // composite glyph.
+    template <typename Function>
+    void for_each_component(
+        std::uint32_t const glyph_offset, Function && function) const;
+
     std::shared_ptr<font_data const> m_data{nullptr};
-    std::map<std::uint16_t, kerning_table> m_kerning_tables{};
-    glyph_index_fn_t m_glyph_index_fn{nullptr};
-    glyph_offset_fn_t m_glyph_offset_fn{nullptr};
+    mutable std::map<std::uint16_t, kerning_table> m_kerning_tables{};
+    mutable glyph_index_fn_t m_glyph_index_fn{nullptr};
+    mutable glyph_offset_fn_t m_glyph_offset_fn{nullptr};
     std::size_t m_data_offset{0u};
-    std::uint32_t m_cmap_index{0};
+    mutable std::uint32_t m_cmap_index{0};
     std::uint32_t m_loca{0};
     std::uint32_t m_glyf{0};
     std::uint32_t m_hmtx{0};
     std::uint32_t m_kern{0};
     std::uint16_t m_num_glyphs{0};
+    std::uint16_t m_index_to_loc_format{0};
     font_metrics m_metrics{0.0f, 0.0f, 0.0f};
     std::uint16_t m_number_of_h_metrics{0};
+
+    mutable detail::once_flag m_cmap_once{};
+    mutable detail::once_flag m_glyphs_once{};
+    mutable detail::once_flag m_kern_once{};
+    mutable font_error m_cmap_error{font_error::none};
+    mutable font_error m_glyphs_error{font_error::none};
+    mutable font_error m_kern_error{font_error::none};
+
+    // For a font read from a file, loca, glyf and the state of each glyph:
+    // zero if not checked yet, glyph_valid or glyph_invalid
+    static constexpr std::uint8_t glyph_valid = 1;
+    static constexpr std::uint8_t glyph_invalid = 2;
+    mutable detail::table m_loca_table{};
+    mutable detail::table m_glyf_table{};
+    mutable std::unique_ptr<std::atomic<std::uint8_t>[]> m_glyph_checks{};
+
+    mutable std::shared_mutex m_components_mutex{};
+    mutable std::unordered_map<std::uint32_t, std::unique_ptr<outline const>>
+        m_components{};
 }; /* class typeface::implementation */
 
+namespace detail
+{
+
+// Builder, which forwards transformed vertices to another builder
+template <typename Builder>
+struct transforming_builder
+{
+    void add_contour(std::size_t s)
+    {
+        builder.add_contour(s);
+    }
+
+    void add_vertex(float x, float y, bool on_curve)
+    {
+        auto const p = t.apply(x, y);
+        builder.add_vertex(p.x, p.y, on_curve);
+    }
+
+    transform const & t;
+    Builder & builder;
+};
+
+} /* namespace detail */
+
+template <typename Function>
+void typeface::implementation::for_each_kerning_pair(
+    Function && function) const
+{
+    load_kerning();
+
+    for(auto const & [glyph1, table]: m_kerning_tables)
+    {
+        for(auto const & [glyph2, value]: table)
+        {
+            function(glyph1, glyph2, value);
+        }
+    }
+}
+
+template <typename Builder>
+void typeface::implementation::decode_glyph(
+    std::uint16_t glyph_index, transform const & t, Builder & builder) const
+{
+    auto const glyph_offs = glyph_offset(glyph_index);
+    if(!glyph_offs)
+        return;
+
+    if(get<std::int16_t>(glyph_offs) > 0)
+    {
+        auto transformed = detail::transforming_builder<Builder>{t, builder};
+        decode_simple_glyph(glyph_offs, transformed);
+        return;
+    }
+
+    // Components are read from the decoded outlines, which are shared by
+    // all composite glyphs using them
+    for_each_simple_glyph(
+        glyph_index, t,
+        [&builder, this](std::uint32_t component_offs, transform const & ct)
+        {
+            auto const & o = component_outline(component_offs);
+            auto transformed =
+                detail::transforming_builder<Builder>{ct, builder};
+
+            for(auto c = std::size_t{0}; c != o.num_contours(); ++c)
+            {
+                auto const first = o.contour_start(c);
+                auto const last = o.contour_end(c);
+                transformed.add_contour(last - first);
+
+                for(auto i = first; i != last; ++i)
+                {
+                    auto const & p = o.position(i);
+                    transformed.add_vertex(
+                        static_cast<float>(p.x), static_cast<float>(p.y),
+                        o.on_curve(i));
+                }
+            }
+        });
+}
+
+template <typename Function>
+void typeface::implementation::for_each_simple_glyph(
+    std::uint16_t glyph_index, transform const & t, Function && function) const
+{
+    auto components = 0u;
+    for_each_simple_glyph(glyph_index, t, 0u, components, function);
+}
+
+template <typename Function>
+void typeface::implementation::for_each_simple_glyph(
+    std::uint16_t glyph_index, transform const & t, unsigned depth,
+    unsigned & components, Function & function) const
+{
+    auto const glyph_offs = glyph_offset(glyph_index);
+    if(!glyph_offs)
+        return;
+
+    auto const num_contours = get<std::int16_t>(glyph_offs);
+    if(num_contours > 0)
+    {
+        function(glyph_offs, t);
+    }
+    else if(num_contours < 0 && depth < max_component_depth)
+    {
+        for_each_component(
+            glyph_offs,
+            [&](std::uint16_t index, transform const & ct)
+            {
+                if(components == max_components)
+                    return;
+
+                ++components;
+                for_each_simple_glyph(
+                    index, t * ct, depth + 1, components, function);
+            });
+    }
+}
+
+template <typename Builder>
+void typeface::implementation::decode_simple_glyph(
+    std::uint32_t const glyph_offset, Builder & builder) const
+{
+    auto const number_of_contours =
+        static_cast<std::uint16_t>(get<std::int16_t>(glyph_offset));
+
+    auto const end_pts_of_countours_offset =
+        glyph_offset + glyph_header::byte_size;
+    auto const instruction_length = get<std::uint16_t>(
+        end_pts_of_countours_offset +
+        number_of_contours * 2u);
+    auto const flags_offset =
+        end_pts_of_countours_offset +
+        number_of_contours*2u +
+        2u +
+        instruction_length;
+
+    auto end_pts = m_data->create_cursor(end_pts_of_countours_offset);
+
+    auto const num_points =
+        std::size_t{1} +
+        end_pts.peek<std::uint16_t>((number_of_contours-1u) * 2u);
+
+    // Flags, x coordinates and y coordinates are stored in separate arrays.
+    // Find where the coordinate arrays start, so that all three can be read
+    // in one pass.
+    auto const x_size = [](std::uint8_t f) -> std::size_t
+    {
+        if(f & simple_glyph_flags::x_short_vector)
+            return 1;
+        return (f & simple_glyph_flags::x_is_same_or_positive_x_short_vector) ?
+            0 : 2;
+    };
+
+    auto flags = m_data->create_cursor(flags_offset);
+    auto x_array_size = std::size_t{0};
+    for(auto i = std::size_t{0}; i < num_points;)
+    {
+        auto const f = flags.read<std::uint8_t>();
+        auto count = std::size_t{1};
+        if(f & simple_glyph_flags::repeat_flag)
+        {
+            count += flags.read<std::uint8_t>();
+        }
+        count = std::min(count, num_points - i);
+
+        x_array_size += count * x_size(f);
+        i += count;
+    }
+
+    auto x_coords = m_data->create_cursor(flags.offset);
+    auto y_coords = m_data->create_cursor(flags.offset + x_array_size);
+    flags.offset = flags_offset;
+
+    auto repeat = 0u;
+    auto current_flags = std::uint8_t{0};
+    auto current_x = std::int16_t{0};
+    auto current_y = std::int16_t{0};
+    auto next_contour = std::size_t{0};
+
+    for(auto i = std::size_t{0}; i < num_points; ++i)
+    {
+        if(repeat == 0)
+        {
+            current_flags = flags.read<std::uint8_t>();
+            if(current_flags & simple_glyph_flags::repeat_flag)
+            {
+                repeat = flags.read<std::uint8_t>();
+            }
+        }
+        else
+        {
+            --repeat;
+        }
+
+        if(current_flags & simple_glyph_flags::x_short_vector)
+        {
+            auto const x = x_coords.read<std::uint8_t>();
+            current_x = static_cast<std::int16_t>(
+                (current_flags & simple_glyph_flags::x_is_same_or_positive_x_short_vector) ?
+                current_x + x : current_x - x);
+        }
+        else if(!(current_flags & simple_glyph_flags::x_is_same_or_positive_x_short_vector))
+        {
+            current_x = static_cast<std::int16_t>(
+                current_x + x_coords.read<std::int16_t>());
+        }
+
+        if(current_flags & simple_glyph_flags::y_short_vector)
+        {
+            auto const y = y_coords.read<std::uint8_t>();
+            current_y = static_cast<std::int16_t>(
+                (current_flags & simple_glyph_flags::y_is_same_or_positive_y_short_vector) ?
+                current_y + y : current_y - y);
+        }
+        else if(!(current_flags & simple_glyph_flags::y_is_same_or_positive_y_short_vector))
+        {
+            current_y = static_cast<std::int16_t>(
+                current_y + y_coords.read<std::int16_t>());
+        }
+
+        if(next_contour == i)
+        {
+            next_contour = std::size_t{1} + end_pts.read<std::uint16_t>();
+            builder.add_contour(next_contour - i);
+        }
+
+        builder.add_vertex(
+            static_cast<float>(current_x),
+            static_cast<float>(current_y),
+            current_flags & simple_glyph_flags::on_curve_point);
+    }
+}
+
+template <typename Function>
+void typeface::implementation::for_each_component(
+    std::uint32_t const glyph_offset, Function && function) const
+{
+    auto data = m_data->create_cursor(glyph_offset+10);
+
+    auto flags =
+        static_cast<uint16_t>(composite_glyph_flags::more_components);
+
+    while(flags & composite_glyph_flags::more_components)
+    {
+        flags = data.read<std::uint16_t>();
+        auto glyph_index = data.read<std::uint16_t>();
+
+        auto p = point{0.0f, 0.0f};
+
+        if(flags & composite_glyph_flags::args_are_xy_values)
+        {
+            if(flags & composite_glyph_flags::arg_1_and_arg_2_are_words)
+            {
+                p.x = data.read<std::int16_t>();
+                p.y = data.read<std::int16_t>();
+            }
+            else
+            {
+                p.x = data.read<std::int8_t>();
+                p.y = data.read<std::int8_t>();
+            }
+        }
+        else
+        {
+            if(flags & composite_glyph_flags::arg_1_and_arg_2_are_words)
+            {
+                data.read<std::uint16_t>();
+                data.read<std::uint16_t>();
+            }
+            else
+            {
+                data.read<std::uint8_t>();
+                data.read<std::uint8_t>();
+            }
+        }
+
+        if(flags & composite_glyph_flags::we_have_a_scale)
+        {
+            auto const scale = data.read<std::int16_t>()/16384.0f;
+            function(glyph_index, transform::from_scale_translate(scale, p));
+        }
+        else if(flags & composite_glyph_flags::we_have_x_and_y_scale)
+        {
+            auto const sx = data.read<std::int16_t>()/16384.0f;
+            auto const sy = data.read<std::int16_t>()/16384.0f;
+            function(
+                glyph_index, transform::from_scale_translate({sx, sy}, p));
+        }
+        else if(flags & composite_glyph_flags::we_have_a_two_by_two)
+        {
+            auto m = std::array<float, 4>{};
+            for(auto & e: m)
+            {
+                e = data.read<std::int16_t>()/16384.0f;
+            }
+            function(glyph_index, transform{m[0], m[1], m[2], m[3], p.x, p.y});
+        }
+        else
+        {
+            function(glyph_index, transform::from_scale_translate(1.0f, p));
+        }
+    }
+}
+
 } /* namespace wttf */
 
 #endif /* WTTF_TYPEFACE_P_HPP */